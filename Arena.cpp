@@ -0,0 +1,245 @@
+﻿#include "Arena.h"
+#include "Memory.h"
+#include "Exception.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace ArenaInternal {
+
+    // максимальный размер, который покрывает 32 битное смещение
+    const uint64_t MAX_ARENA_SIZE = uint64_t(UINT32_MAX) * ARENA_GRANULE;
+
+    const int MAGIC_SIZE = 8;
+    const char MAGIC[MAGIC_SIZE] = "GArena1";
+
+    // Заголовок в начале арены, сохраняется в образ вместе с данными.
+    struct Header
+    {
+        char magic[MAGIC_SIZE];
+        uint64_t base;
+        uint64_t usedSize;
+        uint64_t reservedSize;
+        uint32_t root;
+        uint32_t relocations;
+    };
+
+    // запись о указателе, который нужно исправить при загрузке
+    struct Relocation
+    {
+        uint32_t next;
+        uint32_t slot;
+    };
+
+    const size_t HEADER_SIZE = alignValue(sizeof(Header), ARENA_GRANULE);
+
+    // смещения считаются в ARENA_GRANULE, поэтому записи и исправляемые
+    // указатели по ним всегда выровнены
+    static_assert(
+        ARENA_GRANULE % alignof(Relocation) == 0 && ARENA_GRANULE % alignof(uintptr_t) == 0,
+        "ARENA_GRANULE is too small"
+    );
+
+    Header* getHeader(uint8_t* base)
+    {
+        return reinterpret_cast<Header*>(base);
+    }
+
+    // Лежат ли size байт по смещению offset в данных образа, за заголовком.
+    bool isValidOffset(uint32_t offset, size_t size, size_t usedSize)
+    {
+        uint64_t pos = uint64_t(offset) * ARENA_GRANULE;
+        return pos >= HEADER_SIZE && pos < usedSize && pos + size <= usedSize;
+    }
+
+    void raiseInvalidImage(const char* path)
+    {
+        RAISE(RuntimeException, std::string("Invalid arena image: ") + path);
+    }
+
+    Header readHeader(const char* path)
+    {
+        Header header;
+
+        FILE* file = fopen(path, "rb");
+        if (file == nullptr) {
+            RAISE(RuntimeException, std::string("Cannot open arena image: ") + path);
+        }
+
+        size_t readed = fread(&header, 1, sizeof(header), file);
+        fclose(file);
+
+        if (readed != sizeof(header) || memcmp(header.magic, MAGIC, MAGIC_SIZE) != 0) {
+            raiseInvalidImage(path);
+        }
+
+        // размеры из заголовка не должны выводить за резерв; что файл не
+        // короче usedSize, проверяет Memory::mapFile()
+        if (header.usedSize < HEADER_SIZE || header.usedSize > header.reservedSize ||
+            header.reservedSize > MAX_ARENA_SIZE) {
+            RAISE(RuntimeException, std::string("Invalid arena image size: ") + path);
+        }
+
+        return header;
+    }
+}
+
+using namespace ArenaInternal;
+
+Arena::Arena(size_t reserveSize)
+{
+    if (reserveSize > MAX_ARENA_SIZE) {
+        RAISE(ArgumentException, "Arena size is too big");
+    }
+
+    _size = reserveSize;
+    _base = static_cast<uint8_t*>(Memory::allocRegion(_size));
+    _relocated = false;
+
+    memcpy(getHeader(_base)->magic, MAGIC, MAGIC_SIZE);
+    getHeader(_base)->reservedSize = _size;
+    clear();
+}
+
+Arena::Arena(const char* path)
+{
+    Header header = readHeader(path);
+
+    // резервируем столько же, сколько было у исходной арены, желательно по
+    // тому же адресу, и отображаем файл поверх начала резерва
+    _size = header.reservedSize;
+    _base = static_cast<uint8_t*>(
+        Memory::allocRegion(_size, reinterpret_cast<void*>(header.base))
+    );
+    _pos = header.usedSize;
+
+    try {
+        Memory::mapFile(path, _base, _pos);
+
+        if (header.root != 0 && !isValidOffset(header.root, 1, _pos)) {
+            raiseInvalidImage(path);
+        }
+
+        _relocated = reinterpret_cast<uintptr_t>(_base) != header.base;
+        if (_relocated) {
+            relocate(header.base, path);
+        }
+    }
+    catch (...) {
+        Memory::freeRegion(_base, _size);
+        throw;
+    }
+}
+
+Arena::~Arena()
+{
+    Memory::freeRegion(_base, _size);
+}
+
+void* Arena::alloc(size_t size)
+{
+    return alloc(size, ARENA_GRANULE);
+}
+
+void* Arena::alloc(size_t size, size_t align)
+{
+    if (align < ARENA_GRANULE) {
+        align = ARENA_GRANULE;
+    }
+
+    size_t pos = alignValue(reinterpret_cast<uintptr_t>(_base + _pos), align)
+        - reinterpret_cast<uintptr_t>(_base);
+
+    if (pos + size > _size) {
+        RAISE(BadAllocException, "Arena is full");
+    }
+
+    _pos = pos + size;
+    return _base + pos;
+}
+
+void Arena::clear()
+{
+    // заголовок занимает начало арены, поэтому нулевое смещение никогда
+    // не выдается и служит пустым handle
+    _pos = HEADER_SIZE;
+
+    Header* header = getHeader(_base);
+    header->root = 0;
+    header->relocations = 0;
+}
+
+void Arena::save(const char* path)
+{
+    Header* header = getHeader(_base);
+    header->base = reinterpret_cast<uintptr_t>(_base);
+    header->usedSize = _pos;
+    header->reservedSize = _size;
+
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+        RAISE(RuntimeException, std::string("Cannot create arena image: ") + path);
+    }
+
+    size_t written = fwrite(_base, 1, _pos, file);
+    int closeResult = fclose(file);
+
+    if (written != _pos || closeResult != 0) {
+        RAISE(RuntimeException, std::string("Cannot write arena image: ") + path);
+    }
+}
+
+void Arena::setRoot(void* root)
+{
+    getHeader(_base)->root = root ? toOffset(root) : 0;
+}
+
+void* Arena::getRoot() const
+{
+    uint32_t root = getHeader(_base)->root;
+    return root ? fromOffset(root) : nullptr;
+}
+
+void Arena::addRelocation(void** slot)
+{
+    ASSERT(contains(slot), "Slot is out of arena");
+    ASSERT(checkAlign(slot, ARENA_GRANULE), "Slot is not aligned");
+
+    Header* header = getHeader(_base);
+    auto relocation = static_cast<Relocation*>(alloc(sizeof(Relocation)));
+    relocation->slot = toOffset(slot);
+    relocation->next = header->relocations;
+    header->relocations = toOffset(relocation);
+}
+
+void Arena::relocate(uintptr_t oldBase, const char* path)
+{
+    uintptr_t oldLast = oldBase + _pos;
+    uintptr_t newBase = reinterpret_cast<uintptr_t>(_base);
+
+    // цепочка читается из файла: каждая запись и слот должны лежать в
+    // образе, а записей не может быть больше, чем их помещается в нём,
+    // иначе в цепочке цикл
+    size_t limit = _pos / sizeof(Relocation);
+    uint32_t current = getHeader(_base)->relocations;
+    while (current) {
+        if (limit-- == 0 || !isValidOffset(current, sizeof(Relocation), _pos)) {
+            raiseInvalidImage(path);
+        }
+
+        auto relocation = static_cast<Relocation*>(fromOffset(current));
+        if (!isValidOffset(relocation->slot, sizeof(uintptr_t), _pos)) {
+            raiseInvalidImage(path);
+        }
+
+        auto slot = static_cast<uintptr_t*>(fromOffset(relocation->slot));
+
+        if (*slot >= oldBase && *slot < oldLast) {
+            *slot = *slot - oldBase + newBase;
+        }
+
+        current = relocation->next;
+    }
+
+    getHeader(_base)->base = newBase;
+}
@@ -0,0 +1,218 @@
+﻿#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Align.h"
+#include "Debug.h"
+
+// шаг смещения внутри арены, 32 битное смещение адресует до 32gb
+const size_t ARENA_GRANULE = 8;
+// размер резерва арены по умолчанию
+const size_t ARENA_DEFAULT_SIZE = 256 * 1024 * 1024;
+
+//##############################################################################
+//
+// Handle<T>
+//  Сжатый указатель: 32 битное смещение объекта от начала арены в
+//  единицах ARENA_GRANULE. Нулевое смещение - пустой handle.
+//
+//##############################################################################
+
+template<class T>
+struct Handle
+{
+    uint32_t offset;
+
+    bool isNull() const
+    {
+        return offset == 0;
+    }
+
+    bool operator == (Handle const& other) const
+    {
+        return offset == other.offset;
+    }
+
+    bool operator != (Handle const& other) const
+    {
+        return offset != other.offset;
+    }
+
+    static Handle null()
+    {
+        return Handle { 0 };
+    }
+};
+
+//##############################################################################
+//
+// OffsetPtr<T>
+//  Указатель, хранящий смещение цели относительно самого себя. Остается
+//  верным при отображении образа арены по другому адресу.
+//
+//##############################################################################
+
+template<class T>
+class OffsetPtr
+{
+public:
+    OffsetPtr()
+    {
+        _offset = 0;
+    }
+
+    OffsetPtr(T* value)
+    {
+        set(value);
+    }
+
+    OffsetPtr(const OffsetPtr& src)
+    {
+        set(src.get());
+    }
+
+    OffsetPtr& operator = (const OffsetPtr& src)
+    {
+        set(src.get());
+        return *this;
+    }
+
+    OffsetPtr& operator = (T* value)
+    {
+        set(value);
+        return *this;
+    }
+
+    T* get() const
+    {
+        if (_offset == 0) {
+            return nullptr;
+        }
+
+        auto self = reinterpret_cast<intptr_t>(this);
+        return reinterpret_cast<T*>(self + _offset);
+    }
+
+    T* operator -> () const
+    {
+        return get();
+    }
+
+    T& operator * () const
+    {
+        return *get();
+    }
+private:
+    intptr_t _offset;
+
+    void set(T* value)
+    {
+        _offset = value == nullptr
+            ? 0
+            : reinterpret_cast<intptr_t>(value) - reinterpret_cast<intptr_t>(this);
+    }
+};
+
+//##############################################################################
+//
+// Arena
+//  Непрерывный регион, зарезервированный целиком при создании, с линейным
+//  выделением. Объекты не перемещаются, поэтому внутри арены вместо
+//  указателей можно хранить Handle.
+//
+//  Арену можно сохранить в файл и позже отобразить файл в память вместо
+//  повторного построения данных. Handle и OffsetPtr от адреса не зависят,
+//  обычные указатели внутри арены, зарегистрированные через addRelocation,
+//  исправляются при загрузке, если образ не удалось разместить по
+//  исходному адресу.
+//
+//##############################################################################
+
+class Arena
+{
+public:
+    explicit Arena(size_t reserveSize = ARENA_DEFAULT_SIZE);
+
+    // Загружает образ, сохраненный через save.
+    explicit Arena(const char* path);
+
+    ~Arena();
+
+    void save(const char* path);
+
+    // Корневой объект образа, по нему данные находятся после загрузки.
+    void setRoot(void* root);
+    void* getRoot() const;
+
+    // Регистрирует указатель внутри арены, который нужно исправить, если
+    // образ загружен по другому адресу.
+    void addRelocation(void** slot);
+
+    // Был ли образ загружен не по исходному адресу.
+    bool isRelocated() const
+    {
+        return _relocated;
+    }
+
+    void* alloc(size_t size);
+    void* alloc(size_t size, size_t align);
+
+    // Сбрасывает все выделения, регион остается зарезервированным.
+    void clear();
+
+    size_t usedSize() const
+    {
+        return _pos;
+    }
+
+    size_t reservedSize() const
+    {
+        return _size;
+    }
+
+    bool contains(const void* ptr) const
+    {
+        auto value = static_cast<const uint8_t*>(ptr);
+        return value >= _base && value < _base + _pos;
+    }
+
+    uint32_t toOffset(const void* ptr) const
+    {
+        ASSERT(contains(ptr), "Pointer is out of arena");
+        auto value = static_cast<const uint8_t*>(ptr);
+        return static_cast<uint32_t>((value - _base) / ARENA_GRANULE);
+    }
+
+    void* fromOffset(uint32_t offset) const
+    {
+        return _base + static_cast<size_t>(offset) * ARENA_GRANULE;
+    }
+
+    template<class T>
+    Handle<T> toHandle(T* ptr) const
+    {
+        return Handle<T> { ptr ? toOffset(ptr) : 0 };
+    }
+
+    template<class T>
+    T* get(Handle<T> handle) const
+    {
+        return handle.isNull()
+            ? nullptr
+            : static_cast<T*>(fromOffset(handle.offset));
+    }
+private:
+    Arena(const Arena&) = delete;
+    Arena& operator = (const Arena&) = delete;
+
+    uint8_t* _base;
+    size_t _pos;
+    size_t _size;
+    bool _relocated;
+
+    void relocate(uintptr_t oldBase, const char* path);
+};
+
+#endif // ARENA_H
@@ -0,0 +1,55 @@
+﻿#ifndef BITS_H
+#define BITS_H
+
+#include <stdint.h>
+
+#ifdef MSVC
+#include <intrin.h>
+#endif
+
+// Номер младшего установленного бита. Для нуля результат не определен.
+inline int countTrailingZeros(uint64_t value)
+{
+#ifdef MSVC
+    unsigned long index;
+#ifdef AM64
+    _BitScanForward64(&index, value);
+#else
+    if (static_cast<uint32_t>(value) != 0) {
+        _BitScanForward(&index, static_cast<uint32_t>(value));
+    }
+    else {
+        _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+        index += 32;
+    }
+#endif
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+// Кол-во установленных битов.
+inline int countBits(uint64_t value)
+{
+#ifdef MSVC
+#ifdef AM64
+    return static_cast<int>(__popcnt64(value));
+#else
+    return static_cast<int>(
+        __popcnt(static_cast<uint32_t>(value)) +
+        __popcnt(static_cast<uint32_t>(value >> 32))
+    );
+#endif
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+// Маска из count младших битов, count в диапазоне [0, 64].
+inline uint64_t lowBitsMask(int count)
+{
+    return count >= 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+}
+
+#endif // BITS_H
@@ -0,0 +1,54 @@
+﻿#ifndef ALLOCTRAITS_H
+#define ALLOCTRAITS_H
+
+#include <utility>
+#include <type_traits>
+
+namespace GreedyContainers {
+namespace Internal {
+
+//##############################################################################
+//
+// HasFree
+//  Умеет ли аллокатор возвращать память: есть ли у него метод free(void*).
+//  STLinearAllocator не умеет, STSlabAllocator умеет.
+//
+//##############################################################################
+
+template<class Alloc>
+class HasFree
+{
+    template<class A>
+    static auto check(int) -> decltype(
+        std::declval<A&>().free(std::declval<void*>()),
+        std::true_type()
+    );
+
+    template<class>
+    static std::false_type check(...);
+public:
+    static const bool value = decltype(check<Alloc>(0))::value;
+};
+
+template<class Alloc>
+void freeMemory(Alloc& alloc, void* ptr, std::true_type)
+{
+    alloc.free(ptr);
+}
+
+template<class Alloc>
+void freeMemory(Alloc&, void*, std::false_type)
+{
+}
+
+// Возвращает память аллокатору, если он это умеет.
+template<class Alloc>
+void freeMemory(Alloc& alloc, void* ptr)
+{
+    freeMemory(alloc, ptr, std::integral_constant<bool, HasFree<Alloc>::value>());
+}
+
+}
+}
+
+#endif // ALLOCTRAITS_H
@@ -1,6 +1,9 @@
 ﻿#ifndef ARRAY_H
 #define ARRAY_H
 
+#include <stddef.h>
+#include <iterator>
+
 #include "../Align.h"
 #include "../Debug.h"
 #include "../Exception.h"
@@ -141,12 +144,56 @@ class ArrayBuilder
     using TArray = Array<T>;
     using TArrayData = typename TArray::TData;
 public:
+    // Итератор вывода: *it = item вызывает add(item).
+    class Inserter
+    {
+    public:
+        using iterator_category = std::output_iterator_tag;
+        using value_type = void;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = void;
+
+        explicit Inserter(ArrayBuilder& builder)
+        {
+            _builder = &builder;
+        }
+
+        Inserter& operator*()
+        {
+            return *this;
+        }
+
+        Inserter& operator++()
+        {
+            return *this;
+        }
+
+        Inserter& operator=(T* item)
+        {
+            _builder->add(item);
+            return *this;
+        }
+    private:
+        ArrayBuilder* _builder;
+    };
+
     ArrayBuilder(Alloc& alloc, int limitCount)
     {
         _data = TArrayData::create(alloc, limitCount);
         _limitCout = limitCount;
     }
 
+    int limitCount()
+    {
+        return _limitCout;
+    }
+
+    Inserter inserter()
+    {
+        return Inserter(*this);
+    }
+
     int count()
     {
         if (_data == nullptr) {
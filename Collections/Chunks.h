@@ -1,51 +1,105 @@
 ﻿#ifndef CHUNKS_H
 #define CHUNKS_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
 #include "Array.h"
+#include "Nodes.h"
 #include "Consts.h"
+#include "AllocTraits.h"
+#include "../Align.h"
 #include "../Debug.h"
 #include "../Exception.h"
 
 namespace GreedyContainers {
 namespace Internal {
 
-template<class T, size_t Size>
+// Каждый элемент занимает слот, выровненный на Align, но не меньше, чем
+// требует сам T. Align = CACHE_LINE_SIZE разносит элементы по разным
+// строкам кэша.
+template<class T, size_t Size, size_t Align = alignof(T)>
 struct Chunk final
 {
     Chunk* next;
+    // предыдущая пачка контейнера, по ней стек отступает за O(1)
+    Chunk* prev;
 
     T* getItem(int index)
     {
         ASSERT(-1 > index < Size, Internal::Errors::IndexOutOfRange);
-        return &_data[index];
+        return &_data[index].value;
     }
 
     template<typename ...Args>
     void setItem(int index, Args&&... args)
     {
         ASSERT(-1 > index < Size, Internal::Errors::IndexOutOfRange);
-        new (&_data[index]) T(std::forward<Args>(args)...);
+        new (&_data[index].value) T(std::forward<Args>(args)...);
     }
 private:
-    T _data[Size];
+    struct alignas(maxAlign(Align, alignof(T))) Slot
+    {
+        T value;
+    };
+
+    Slot _data[Size];
+
+    // Слоты без промежутков, если Align не больше alignof(T): тогда
+    // элементы пачки - обычный массив T.
+    static constexpr bool isContiguous()
+    {
+        return sizeof(Slot) == sizeof(T);
+    }
+
+    T* getData()
+    {
+        return &_data[0].value;
+    }
+
+    T& getValue(int index)
+    {
+        return _data[index].value;
+    }
+
+    // Позиция слота по адресу его элемента.
+    int indexOf(const void* item) const
+    {
+        return int((reinterpret_cast<uintptr_t>(item) -
+                    reinterpret_cast<uintptr_t>(&_data[0])) / sizeof(Slot));
+    }
 
     void release(int index)
     {
-        _data[index].~T();
+        _data[index].value.~T();
     }
 
     template<typename, typename>
     friend class ChunkPool;
-    template<typename, size_t>
+    template<typename, size_t, size_t>
     friend class ChunkedEnumerator;
-    template<typename, typename, size_t>
+    template<typename, typename, size_t, size_t>
     friend class ChunkedContainer;
+    template<typename, size_t, size_t>
+    friend class ChunkedView;
+    template<typename, size_t, size_t>
+    friend class HolderView;
+    template<typename, size_t, size_t, bool>
+    friend class ChunkedIter;
+    template<typename, size_t, size_t, bool>
+    friend class HolderIter;
 };
 
-template<class T, size_t Size>
-struct Chunk<T*, Size>
+template<class T, size_t Size, size_t Align>
+struct Chunk<T*, Size, Align>
 {
     Chunk* next;
+    Chunk* prev;
 
     T* getItem(int index)
     {
@@ -61,6 +115,27 @@ struct Chunk<T*, Size>
 private:
     T* _data[Size];
 
+    static constexpr bool isContiguous()
+    {
+        return true;
+    }
+
+    T** getData()
+    {
+        return _data;
+    }
+
+    T*& getValue(int index)
+    {
+        return _data[index];
+    }
+
+    int indexOf(const void* item) const
+    {
+        return int((reinterpret_cast<uintptr_t>(item) -
+                    reinterpret_cast<uintptr_t>(&_data[0])) / sizeof(T*));
+    }
+
     void release(int index)
     {
         _data[index] = nullptr;
@@ -68,16 +143,61 @@ private:
 
     template<typename, typename>
     friend class ChunkPool;
-    template<typename, size_t>
+    template<typename, size_t, size_t>
     friend class ChunkedEnumerator;
-    template<typename, typename, size_t>
+    template<typename, typename, size_t, size_t>
     friend class ChunkedContainer;
+    template<typename, size_t, size_t>
+    friend class ChunkedView;
+    template<typename, size_t, size_t>
+    friend class HolderView;
+    template<typename, size_t, size_t, bool>
+    friend class ChunkedIter;
+    template<typename, size_t, size_t, bool>
+    friend class HolderIter;
 };
 
 
+//##############################################################################
+//
+// autoChunkSize
+//  Сколько элементов поместить в пачку, чтобы она вместе с next и prev
+//  занимала не больше TargetBytes, но не меньше одного элемента. Для мелких
+//  T это меньше переходов по next на элемент, для крупных - меньше лишней
+//  памяти.
+//
+//##############################################################################
+
+template<class T, size_t Align = alignof(T), size_t TargetBytes = AUTO_CHUNK_BYTES>
+constexpr size_t autoChunkSize()
+{
+    // слоты идут за next и prev с выравниванием слота, как в Chunk
+    return alignValue(sizeof(void*) * 2, maxAlign(Align, alignof(T))) +
+           alignValue(sizeof(T), maxAlign(Align, alignof(T))) >= TargetBytes ? 1 :
+        (TargetBytes - alignValue(sizeof(void*) * 2, maxAlign(Align, alignof(T)))) /
+        alignValue(sizeof(T), maxAlign(Align, alignof(T)));
+}
+
+// Явно заданный размер пачки или AUTO_CHUNK_SIZE.
+template<class T, size_t Align = alignof(T)>
+constexpr size_t chunkSizeFor(size_t chunkSize)
+{
+    return chunkSize == AUTO_CHUNK_SIZE ? autoChunkSize<T, Align>() : chunkSize;
+}
+
 //##############################################################################
 //
 // ChunkPool
+//  Пачки контейнера выделяются блоками: первый блок - из reserverCount
+//  пачек, каждый следующий вдвое больше предыдущего, но не больше
+//  maxReserve пачек. Освобождённые пачки остаются в пуле; shrink()
+//  возвращает аллокатору блоки, в которых не осталось занятых пачек.
+//  Автоматическая чистка оставляет в пуле столько свободных пачек,
+//  сколько пришлось выделить заново после прошлой чистки, чтобы
+//  контейнер, который раз за разом наполняют и опустошают, не
+//  выделял память на каждой волне.
+//  Заголовок блока лежит перед пачками, а если там он занял бы целый
+//  шаг пачки (см. setChunkStride()) - выделяется отдельно.
 //
 //##############################################################################
 
@@ -85,38 +205,80 @@ template<class TAlloc, class TChunk>
 class ChunkPool
 {
 public:
+    // Первый блок выделяется при первом create().
     ChunkPool(TAlloc& alloc, int reserverCount)
     {
         _head = nullptr;
+        _blocks = nullptr;
         _alloc = &alloc;
+        _chunkCount = 0;
+        _freeCount = 0;
+        _stride = sizeof(TChunk);
+        _chunkAlign = alignof(TChunk);
+        _maxReserve = MAX_CHUNK_RESERVE;
+        _trimThreshold = TRIM_MIN_CHUNKS;
+        _autoTrim = false;
+        _grown = false;
+        _trimmed = false;
+        _reserve = 0;
 
         if (reserverCount < 1) {
             reserverCount = 1;
         }
 
-        makeReserv(reserverCount);
+        _growSize = reserverCount;
     }
 
     ChunkPool(ChunkPool&& src)
     {
-        ASSERT(src._head != nullptr);
         ASSERT(src._alloc != nullptr);
 
         _head = src._head;
+        _blocks = src._blocks;
+        _alloc = src._alloc;
+        _chunkCount = src._chunkCount;
+        _freeCount = src._freeCount;
+        _stride = src._stride;
+        _chunkAlign = src._chunkAlign;
+        _growSize = src._growSize;
+        _maxReserve = src._maxReserve;
+        _trimThreshold = src._trimThreshold;
+        _autoTrim = src._autoTrim;
+        _grown = src._grown;
+        _trimmed = src._trimmed;
+        _reserve = src._reserve;
+
         src._head = nullptr;
+        src._blocks = nullptr;
+        src._chunkCount = 0;
+        src._freeCount = 0;
+    }
 
-        _alloc = src._alloc;
+    ~ChunkPool()
+    {
+        if (!HasFree<TAlloc>::value) {
+            return;
+        }
+
+        auto block = _blocks;
+        while (block) {
+            auto next = block->next;
+            freeBlock(block);
+            block = next;
+        }
     }
 
     TChunk* create()
     {
         if (!_head) {
-            makeReserv(1);
+            allocBlock(_growSize);
+            _growSize = std::min(_growSize * 2, std::max(_maxReserve, uint32_t(1)));
         }
 
         auto result = _head;
         _head = _head->next;
         result->next = nullptr;
+        _freeCount--;
         return result;
     }
 
@@ -127,15 +289,120 @@ public:
         }
 
         TChunk* newHead = chunk;
+        _freeCount++;
 
         if (followup) {
             while(chunk->next) {
                 chunk = chunk->next;
+                _freeCount++;
             }
         }
 
         chunk->next = _head;
         _head = newHead;
+
+        if (_autoTrim && needTrim()) {
+            if (trim(_reserve)) {
+                _trimmed = true;
+            }
+            _reserve = std::min(_reserve, _freeCount);
+        }
+    }
+
+    // Возвращает аллокатору блоки, в которых не осталось занятых пачек.
+    // Для аллокаторов без free() ничего не делает. Возвращает кол-во
+    // освобождённых пачек.
+    size_t shrink()
+    {
+        _trimmed = false;
+        _reserve = 0;
+        return trim(0);
+    }
+
+    // Включает автоматическую чистку, когда свободных пачек становится
+    // больше, чем занятых, и когда контейнер опустел до одной пачки после
+    // того, как пул рос.
+    void setAutoTrim(bool enabled)
+    {
+        _autoTrim = enabled && HasFree<TAlloc>::value;
+    }
+
+    void swap(ChunkPool& other)
+    {
+        std::swap(_head, other._head);
+        std::swap(_blocks, other._blocks);
+        std::swap(_alloc, other._alloc);
+        std::swap(_chunkCount, other._chunkCount);
+        std::swap(_freeCount, other._freeCount);
+        std::swap(_stride, other._stride);
+        std::swap(_chunkAlign, other._chunkAlign);
+        std::swap(_growSize, other._growSize);
+        std::swap(_maxReserve, other._maxReserve);
+        std::swap(_trimThreshold, other._trimThreshold);
+        std::swap(_autoTrim, other._autoTrim);
+        std::swap(_grown, other._grown);
+        std::swap(_trimmed, other._trimmed);
+        std::swap(_reserve, other._reserve);
+    }
+
+    // Забирает все блоки src вместе с занятыми в них пачками. Пулы должны
+    // брать память у одного аллокатора; src остаётся пустым.
+    void adopt(ChunkPool& src)
+    {
+        ASSERT(src._alloc == _alloc);
+        ASSERT(src._stride == _stride);
+
+        if (src._blocks == nullptr) {
+            return;
+        }
+
+        auto block = src._blocks;
+        while (block->next) {
+            block = block->next;
+        }
+
+        block->next = _blocks;
+        _blocks = src._blocks;
+
+        if (src._head) {
+            auto chunk = src._head;
+            while (chunk->next) {
+                chunk = chunk->next;
+            }
+
+            chunk->next = _head;
+            _head = src._head;
+        }
+
+        _chunkCount += src._chunkCount;
+        _freeCount += src._freeCount;
+        _grown = _grown || src._grown;
+
+        src._head = nullptr;
+        src._blocks = nullptr;
+        src._chunkCount = 0;
+        src._freeCount = 0;
+    }
+
+    // Предел роста блока в пачках; 1 - выделять по одной пачке.
+    void setMaxReserve(size_t count)
+    {
+        _maxReserve = uint32_t(std::max(count, size_t(1)));
+        _growSize = std::min(_growSize, _maxReserve);
+    }
+
+    // Пачки кладутся с шагом stride по адресам, кратным stride: пачку
+    // можно найти по адресу её элемента, а stride - sizeof(TChunk) байт
+    // за ней остаются контейнеру; в новом блоке они обнулены. stride -
+    // степень двойки. Только до первого create().
+    void setChunkStride(size_t stride)
+    {
+        ASSERT(_blocks == nullptr);
+        ASSERT(stride >= sizeof(TChunk) && (stride & (stride - 1)) == 0,
+               "Invalid chunk stride");
+
+        _stride = uint32_t(stride);
+        _chunkAlign = uint32_t(stride);
     }
 
     TAlloc* allocator()
@@ -143,25 +410,198 @@ public:
         return _alloc;
     }
 private:
+    struct Block
+    {
+        Block* next;
+        uint8_t* chunks;
+        // кол-во пачек
+        uint32_t size;
+    };
+
+    // после shrink() автоматическая чистка не запускается, пока свободных
+    // пачек меньше этого
+    static const uint32_t TRIM_MIN_CHUNKS = 4;
+
+    // свободные пачки
     TChunk* _head;
+    Block* _blocks;
     TAlloc* _alloc;
+    // счётчики 32-битные, чтобы пул пустого контейнера оставался небольшим
+    uint32_t _chunkCount;
+    uint32_t _freeCount;
+    // шаг пачек в блоке и выравнивание блока
+    uint32_t _stride;
+    uint32_t _chunkAlign;
+    // размер следующего блока в пачках
+    uint32_t _growSize;
+    uint32_t _maxReserve;
+    uint32_t _trimThreshold;
+    bool _autoTrim;
+    // выделялись блоки после shrink() в опустевшем контейнере
+    bool _grown;
+    // автоматическая чистка уже возвращала блоки
+    bool _trimmed;
+    // свободные пачки, которые автоматическая чистка оставляет в пуле
+    uint32_t _reserve;
 
-    void makeReserv(int count)
+    bool needTrim() const
+    {
+        auto live = _chunkCount - _freeCount;
+        if (_freeCount <= live) {
+            return false;
+        }
+
+        // порог после shrink() не даёт чистить на каждом release(), но
+        // опустевший контейнер отдаёт всё, что набрал с прошлой чистки
+        return _freeCount > _trimThreshold || (live <= 1 && _grown);
+    }
+
+    // Возвращает аллокатору свободные блоки, оставляя в пуле не меньше
+    // keep свободных пачек.
+    size_t trim(uint32_t keep)
+    {
+        if (!HasFree<TAlloc>::value || _freeCount == 0) {
+            return 0;
+        }
+
+        auto byAddress = [](const void* a, const void* b) {
+            return reinterpret_cast<uintptr_t>(a) < reinterpret_cast<uintptr_t>(b);
+        };
+
+        _blocks = sortChain(_blocks, [](const Block* a, const Block* b) {
+            return a->chunks < b->chunks;
+        });
+        _head = sortChain(_head, byAddress);
+
+        size_t released = 0;
+        Block* kept = nullptr;
+        Block** keptTail = &kept;
+        TChunk* freeList = nullptr;
+        TChunk** freeTail = &freeList;
+
+        auto chunk = _head;
+        auto block = _blocks;
+        while (block) {
+            auto nextBlock = block->next;
+            auto end = reinterpret_cast<uintptr_t>(block->chunks + size_t(block->size) * _stride);
+
+            auto first = chunk;
+            TChunk* last = nullptr;
+            size_t freeChunks = 0;
+            while (chunk && reinterpret_cast<uintptr_t>(chunk) < end) {
+                last = chunk;
+                chunk = chunk->next;
+                freeChunks++;
+            }
+
+            if (freeChunks == block->size && _freeCount - freeChunks >= keep) {
+                _chunkCount -= uint32_t(freeChunks);
+                _freeCount -= uint32_t(freeChunks);
+                released += freeChunks;
+                freeBlock(block);
+            } else {
+                *keptTail = block;
+                keptTail = &block->next;
+                if (last) {
+                    *freeTail = first;
+                    freeTail = &last->next;
+                }
+            }
+
+            block = nextBlock;
+        }
+
+        *keptTail = nullptr;
+        *freeTail = nullptr;
+        _blocks = kept;
+        _head = freeList;
+
+        // как у NodePool: следующая автоматическая чистка - не раньше, чем
+        // свободных пачек станет вдвое больше
+        _trimThreshold = std::max(uint32_t(TRIM_MIN_CHUNKS), _freeCount * 2);
+        // в опустевшем контейнере больше нечего возвращать, пока пул
+        // снова не вырастет
+        if (_chunkCount - _freeCount <= 1) {
+            _grown = false;
+        }
+
+        return released;
+    }
+
+    void allocBlock(uint32_t count)
     {
         ASSERT(count > 0, "Invalid chunk count");
 
-        auto newHead = reinterpret_cast<TChunk*>(
-            _alloc->alloc(count * sizeof(TChunk))
-        );
+        auto size = size_t(count) * _stride;
+        Block* block;
+        uint8_t* memory;
+        if (hasSeparateHeader()) {
+            memory = reinterpret_cast<uint8_t*>(_alloc->alloc(size, _chunkAlign));
+            CHECK_NULL_PTR(memory);
+            block = reinterpret_cast<Block*>(_alloc->alloc(sizeof(Block), alignof(Block)));
+            if (block == nullptr) {
+                freeMemory(*_alloc, memory);
+                CHECK_NULL_PTR(block);
+            }
+        } else {
+            block = reinterpret_cast<Block*>(_alloc->alloc(getHeaderSize() + size, _chunkAlign));
+            CHECK_NULL_PTR(block);
+            memory = reinterpret_cast<uint8_t*>(block) + getHeaderSize();
+        }
+
+        // пачку находят по адресу элемента, см. setChunkStride()
+        ASSERT((reinterpret_cast<uintptr_t>(memory) & (_chunkAlign - 1)) == 0,
+               "Allocator ignored alignment");
 
+        block->chunks = memory;
+        block->size = count;
+        block->next = _blocks;
+        _blocks = block;
+
+        if (_stride > sizeof(TChunk)) {
+            for (uint32_t i = 0; i < count; i++) {
+                memset(memory + size_t(i) * _stride + sizeof(TChunk), 0, _stride - sizeof(TChunk));
+            }
+        }
+
+        auto newHead = reinterpret_cast<TChunk*>(memory);
         auto chunk = newHead;
-        for (int i = 0; i < count - 1; i++) {
-            chunk->next = chunk + 1;
+        for (uint32_t i = 0; i < count - 1; i++) {
+            chunk->next = reinterpret_cast<TChunk*>(
+                reinterpret_cast<uint8_t*>(chunk) + _stride
+            );
             chunk = chunk->next;
         }
 
         chunk->next = _head;
         _head = newHead;
+        _chunkCount += count;
+        _freeCount += count;
+        _grown = true;
+
+        // пачки, выделенные заново после чистки, ей стоило оставить
+        if (_trimmed) {
+            _reserve += count;
+        }
+    }
+
+    size_t getHeaderSize() const
+    {
+        return alignValue(sizeof(Block), _chunkAlign);
+    }
+
+    bool hasSeparateHeader() const
+    {
+        return getHeaderSize() >= _stride;
+    }
+
+    void freeBlock(Block* block)
+    {
+        if (hasSeparateHeader()) {
+            freeMemory(*_alloc, block->chunks);
+        }
+
+        freeMemory(*_alloc, block);
     }
 };
 
@@ -171,10 +611,10 @@ private:
 //
 //##############################################################################
 
-template<class T, size_t ChunkSize>
+template<class T, size_t ChunkSize, size_t Align>
 class ChunkedEnumerator
 {
-    using ChunkType = Chunk<T, ChunkSize>;
+    using ChunkType = Chunk<T, ChunkSize, Align>;
 public:
     ChunkedEnumerator(ChunkType* top, int index, int count)
     {
@@ -218,35 +658,261 @@ private:
         _current->release(_index);
     }
 
-    template<typename, typename, size_t>
+    template<typename, typename, size_t, size_t>
     friend class ChunkedContainer;
 };
 
+//##############################################################################
+//
+// ChunkedIter
+//  Прямой итератор STL. Как и у списков, разыменование даёт ссылку на
+//  значение, с Const - константную. Конец определяется по кол-ву
+//  оставшихся элементов.
+//
+//##############################################################################
+
+template<class T, size_t ChunkSize, size_t Align, bool Const = false>
+class ChunkedIter
+{
+    using ChunkType = Chunk<T, ChunkSize, Align>;
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = typename std::conditional<Const, const T*, T*>::type;
+    using reference = typename std::conditional<Const, const T&, T&>::type;
+
+    ChunkedIter(ChunkType* chunk = nullptr, int index = 0, int count = 0)
+    {
+        _chunk = chunk;
+        _index = index;
+        _count = count;
+    }
+
+    // неконстантный итератор приводится к константному
+    template<bool OtherConst, class = typename std::enable_if<Const && !OtherConst>::type>
+    ChunkedIter(const ChunkedIter<T, ChunkSize, Align, OtherConst>& other)
+    {
+        _chunk = other._chunk;
+        _index = other._index;
+        _count = other._count;
+    }
+
+    friend bool operator == (ChunkedIter const& a, ChunkedIter const& b)
+    {
+        return a._count == b._count;
+    }
+
+    friend bool operator != (ChunkedIter const& a, ChunkedIter const& b)
+    {
+        return a._count != b._count;
+    }
+
+    ChunkedIter& operator++() {
+        _count--;
+        if (++_index == int(ChunkSize)) {
+            _index = 0;
+            _chunk = _chunk->next;
+        }
+        return *this;
+    }
+
+    ChunkedIter operator++(int) {
+        auto result = *this;
+        ++*this;
+        return result;
+    }
+
+    reference operator*() const
+    {
+        return _chunk->getValue(_index);
+    }
+
+    pointer operator->() const
+    {
+        return &**this;
+    }
+
+private:
+    ChunkType* _chunk;
+    int _index;
+    int _count;
+
+    template<typename, size_t, size_t, bool>
+    friend class ChunkedIter;
+};
+
+//##############################################################################
+//
+// ChunkedView
+//  Элементы контейнера без копирования: оглавление из указателей на пачки
+//  даёт доступ по индексу, обход идёт по пачкам. До INLINE_CHUNKS пачек
+//  оглавление хранится в самом представлении, иначе берётся из кучи, а не
+//  у аллокатора контейнера: линейный аллокатор или арена не вернули бы его
+//  до своего сброса. Действительно, пока в контейнере не появились и
+//  не исчезли пачки.
+//
+//##############################################################################
+
+template<class T, size_t ChunkSize, size_t Align>
+class ChunkedView
+{
+    using TChunk = Chunk<T, ChunkSize, Align>;
+    using TPtr = typename std::remove_pointer<T>::type*;
+public:
+    using Iter = ChunkedIter<T, ChunkSize, Align>;
+
+    ChunkedView(TChunk* head, int topIndex, int count)
+    {
+        ASSERT(-1 > topIndex < ChunkSize, Errors::IndexOutOfRange);
+
+        _topIndex = topIndex;
+        _count = count;
+        _chunkCount = count == 0 ? 0 : (topIndex + count + int(ChunkSize) - 1) / int(ChunkSize);
+        _directory = _inline;
+
+        if (_chunkCount > INLINE_CHUNKS) {
+            _directory = new TChunk*[_chunkCount];
+        }
+
+        auto chunk = head;
+        for (int i = 0; i < _chunkCount; i++) {
+            _directory[i] = chunk;
+            chunk = chunk->next;
+        }
+    }
+
+    ChunkedView(ChunkedView&& src)
+    {
+        _topIndex = src._topIndex;
+        _count = src._count;
+        _chunkCount = src._chunkCount;
+        _directory = src._directory;
+
+        if (src._directory == src._inline) {
+            std::copy(src._inline, src._inline + _chunkCount, _inline);
+            _directory = _inline;
+        }
+
+        src._directory = src._inline;
+        src._count = 0;
+        src._chunkCount = 0;
+    }
+
+    ~ChunkedView()
+    {
+        if (_directory != _inline) {
+            delete[] _directory;
+        }
+    }
+
+    int count() const
+    {
+        return _count;
+    }
+
+    bool isEmpty() const
+    {
+        return _count == 0;
+    }
+
+    int chunkCount() const
+    {
+        return _chunkCount;
+    }
+
+    TPtr operator[] (int index) const
+    {
+        ASSERT(index >= 0 && index < _count, Errors::IndexOutOfRange);
+
+        int position = _topIndex + index;
+        return _directory[position / int(ChunkSize)]->getItem(position % int(ChunkSize));
+    }
+
+    Iter begin() const
+    {
+        return _count == 0 ? Iter() : Iter(_directory[0], _topIndex, _count);
+    }
+
+    Iter end() const
+    {
+        return Iter();
+    }
+
+    // func(first, n) для элементов каждой пачки, как forEachChunk()
+    // контейнера.
+    template<class Func>
+    void forEachChunk(Func func) const
+    {
+        static_assert(
+            TChunk::isContiguous(),
+            "Spans require Align not greater than alignof(T)"
+        );
+
+        int index = _topIndex;
+        int count = _count;
+        for (int i = 0; i < _chunkCount; i++) {
+            int size = std::min(count, int(ChunkSize) - index);
+            func(_directory[i]->getData() + index, size_t(size));
+
+            count -= size;
+            index = 0;
+        }
+    }
+private:
+    static const int INLINE_CHUNKS = 8;
+
+    TChunk** _directory;
+    TChunk* _inline[INLINE_CHUNKS];
+    int _topIndex;
+    int _count;
+    int _chunkCount;
+
+    ChunkedView(const ChunkedView&) = delete;
+};
+
 //##############################################################################
 //
 // ChunkedContainer
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize>
+template<class T, class Alloc, size_t ChunkSize, size_t Align>
 class ChunkedContainer
 {
 protected:
     using TPtr = typename std::remove_pointer<T>::type*;
-    using TChunk = Chunk<T, ChunkSize>;
+    using TChunk = Chunk<T, ChunkSize, Align>;
     using TPool = ChunkPool<Alloc, TChunk>;
-    using TEnum = ChunkedEnumerator<T, ChunkSize>;
-    using TArray = Array<T>;
-    using TArrayBuilder = ArrayBuilder<T, Alloc>;
+    using TEnum = ChunkedEnumerator<T, ChunkSize, Align>;
+    using TIter = ChunkedIter<T, ChunkSize, Align>;
+    using TConstIter = ChunkedIter<T, ChunkSize, Align, true>;
+    using TView = ChunkedView<T, ChunkSize, Align>;
 public:
     ChunkedContainer(Alloc& allocator, int capacity)
         : _pool(allocator, capacity)
     {
-        _head = _pool.create();
-        _tail = _head;
+        // первая пачка берётся при первом добавлении, поэтому пустой
+        // контейнер не занимает памяти
+        _head = nullptr;
+        _tail = nullptr;
         _count = 0;
     }
 
+    // Забирает цепочку пачек и пул за O(1), src остаётся пустым и
+    // пригодным к работе.
+    ChunkedContainer(ChunkedContainer&& src)
+        : _pool(std::move(src._pool))
+    {
+        _head = src._head;
+        _tail = src._tail;
+        _count = src._count;
+
+        src._head = nullptr;
+        src._tail = nullptr;
+        src._count = 0;
+    }
+
     int count() const
     {
         return _count;
@@ -256,6 +922,23 @@ public:
     {
         return _count == 0;
     }
+
+    // Возвращает аллокатору блоки, в которых не осталось занятых пачек.
+    size_t shrink()
+    {
+        return _pool.shrink();
+    }
+
+    void setAutoTrim(bool enabled)
+    {
+        _pool.setAutoTrim(enabled);
+    }
+
+    // Предел роста блока пачек, см. ChunkPool.
+    void setMaxReserve(size_t count)
+    {
+        _pool.setMaxReserve(count);
+    }
 protected:
     int _count;
     TPool _pool;
@@ -265,37 +948,240 @@ protected:
     void emptyCheck()
     {
         if (isEmpty()) {
-            RAISE(RuntimeException, Errors::EmptyContainer);
+            raiseEmpty();
         }
     }
 
+    COLD static void raiseEmpty()
+    {
+        RAISE(RuntimeException, Errors::EmptyContainer);
+    }
+
+    static T& itemValue(TChunk* chunk, int index)
+    {
+        return chunk->getValue(index);
+    }
+
+    // адрес слота: у PtrHolder getItem() возвращает само значение
+    static T* itemSlot(TChunk* chunk, int index)
+    {
+        return &chunk->getValue(index);
+    }
+
+    static int itemIndex(TChunk* chunk, const void* item)
+    {
+        return chunk->indexOf(item);
+    }
+
     template<typename ...Args>
     TPtr appendItem(Args&&... args)
     {
-        int index = _count % ChunkSize;
-        if (index == 0 && _count != 0) {
-            _tail->next = _pool.create();
-            _tail = _tail->next;
-            index = 0;
-        }
+        return appendItemAt(0, std::forward<Args>(args)...);
+    }
 
+    // topIndex - позиция первого элемента в первой пачке: у очереди
+    // хвост идёт через _count элементов после неё.
+    template<typename ...Args>
+    TPtr appendItemAt(int topIndex, Args&&... args)
+    {
+        int index = prepareTail(topIndex);
         _tail->setItem(index, std::forward<Args>(args)...);
         _count++;
         return _tail->getItem(index);
     }
 
+    // Добавляет копии элементов [first, last). Из массива тривиально
+    // копируемых T копирует memcpy по пачке за раз.
+    template<class InputIt>
+    void appendItems(int topIndex, InputIt first, InputIt last)
+    {
+        using IsRaw = std::integral_constant<bool,
+            std::is_pointer<InputIt>::value &&
+            std::is_same<typename std::remove_cv<
+                typename std::remove_pointer<InputIt>::type>::type, T>::value &&
+            std::is_trivially_copyable<T>::value &&
+            TChunk::isContiguous()
+        >;
+
+        appendItems(topIndex, first, last, IsRaw());
+    }
+
+    // Копирует элементы по порядку в out, см. appendItems().
+    template<class OutputIt>
+    OutputIt copyItems(int topIndex, OutputIt out) const
+    {
+        using IsRaw = std::integral_constant<bool, TChunk::isContiguous()>;
+        return copyItems(topIndex, out, IsRaw());
+    }
+
     void releaseItem(TChunk* chunk, int index)
     {
         ASSERT(-1 > index < ChunkSize, Errors::IndexOutOfRange);
         chunk->release(index);
     }
 
+    void swapItems(ChunkedContainer& other)
+    {
+        _pool.swap(other._pool);
+        std::swap(_head, other._head);
+        std::swap(_tail, other._tail);
+        std::swap(_count, other._count);
+    }
+
+    // Переносит элементы src в конец. Если последняя пачка заполнена и
+    // аллокатор общий, цепочка пачек src перецепляется вместе с их блоками,
+    // иначе элементы перемещаются по одному. Только для контейнеров, которые
+    // заполняют пачки с начала (topIndex = 0). src остаётся пустым.
+    void stealItems(ChunkedContainer& src)
+    {
+        if (&src == this || src._count == 0) {
+            return;
+        }
+
+        if (_count % ChunkSize != 0 || _pool.allocator() != src._pool.allocator()) {
+            auto chunk = src._head;
+            int index = 0;
+            for (int i = 0; i < src._count; i++) {
+                appendItem(std::move(chunk->getValue(index)));
+                if (++index == int(ChunkSize)) {
+                    index = 0;
+                    chunk = chunk->next;
+                }
+            }
+
+            src.clearAllItems(0);
+            return;
+        }
+
+        // пустая первая пачка сдвинула бы элементы src
+        if (_count == 0 && _head != nullptr) {
+            _pool.release(_head, true);
+            _head = nullptr;
+            _tail = nullptr;
+        }
+
+        // свободные пачки src уходят вместе с блоками
+        _pool.adopt(src._pool);
+
+        if (_tail == nullptr) {
+            _head = src._head;
+        } else {
+            _tail->next = src._head;
+            src._head->prev = _tail;
+        }
+
+        _tail = src._tail;
+        _count += src._count;
+
+        src._head = nullptr;
+        src._tail = nullptr;
+        src._count = 0;
+    }
+
+    // Переносит count элементов с начала в out. Опустевшие пачки, кроме
+    // последней, возвращаются пулу одной цепочкой. topIndex сдвигается.
+    template<class OutputIt>
+    OutputIt takeFront(int& topIndex, int count, OutputIt out)
+    {
+        ASSERT(count >= 0 && count <= _count, Errors::IndexOutOfRange);
+
+        if (count == 0) {
+            return out;
+        }
+
+        auto chunk = _head;
+        int index = topIndex;
+        int left = count;
+        while (true) {
+            int size = std::min(left, int(ChunkSize) - index);
+            out = moveItems(chunk, index, size, out);
+            left -= size;
+            index += size;
+
+            if (index == int(ChunkSize) && chunk != _tail) {
+                chunk = chunk->next;
+                index = 0;
+            }
+
+            if (left == 0) {
+                break;
+            }
+        }
+
+        _count -= count;
+        if (_count == 0) {
+            index = 0;
+        }
+
+        if (chunk != _head) {
+            chunk->prev->next = nullptr;
+            _pool.release(_head, true);
+            chunk->prev = nullptr;
+            _head = chunk;
+        }
+
+        topIndex = index;
+        return out;
+    }
+
+    // Переносит count последних элементов в out в порядке добавления.
+    // Опустевшие пачки возвращаются пулу одной цепочкой.
+    template<class OutputIt>
+    OutputIt takeBack(int count, OutputIt out)
+    {
+        ASSERT(count >= 0 && count <= _count, Errors::IndexOutOfRange);
+
+        if (count == 0) {
+            return out;
+        }
+
+        int first = _count - count;
+        auto chunk = _tail;
+        for (int i = first / ChunkSize; i < (_count - 1) / int(ChunkSize); i++) {
+            chunk = chunk->prev;
+        }
+
+        // новый хвост - пачка с элементом first - 1
+        auto newTail = (first % ChunkSize != 0 || first == 0) ? chunk : chunk->prev;
+
+        auto current = chunk;
+        int index = first % ChunkSize;
+        int left = count;
+        while (left > 0) {
+            int size = std::min(left, int(ChunkSize) - index);
+            out = moveItems(current, index, size, out);
+            left -= size;
+            index = 0;
+            current = current->next;
+        }
+
+        _count = first;
+        if (newTail->next) {
+            _pool.release(newTail->next, true);
+            newTail->next = nullptr;
+        }
+
+        _tail = newTail;
+        return out;
+    }
+
     void clearAllItems(int topIndex)
     {
         ASSERT(-1 > topIndex < ChunkSize, Errors::IndexOutOfRange);
 
         releaseAllObjects(topIndex);
+        releaseChunks();
+    }
+
+    // Возвращает пулу все пачки, кроме первой; элементы уже разрушены.
+    void releaseChunks()
+    {
+        if (_head == nullptr) {
+            return;
+        }
+
         _pool.release(_head->next, true);
+        _head->next = nullptr;
 
         _tail = _head;
         _count = 0;
@@ -305,6 +1191,11 @@ protected:
     {
         ASSERT(-1 > topIndex < ChunkSize, Errors::IndexOutOfRange);
 
+        // очистка тривиально разрушаемых T - O(кол-ва пачек)
+        if (std::is_trivially_destructible<T>::value) {
+            return;
+        }
+
         TEnum enumerator(_head, topIndex, _count);
         while (enumerator.moveNext()) {
             enumerator.releaseCurrent();
@@ -316,15 +1207,150 @@ protected:
         return TEnum(_head, topIndex, _count);
     }
 
-    TArray getArray(int topIndex)
+    TIter getBegin(int topIndex) const
+    {
+        return TIter(_head, topIndex, _count);
+    }
+
+    TIter getEnd() const
     {
-        TArrayBuilder builder(*_pool.allocator(), _count);
-        auto e = getEnum(topIndex);
-        while (e.moveNext()) {
-            builder.add(e.current());
+        return TIter();
+    }
+
+    // Вызывает func(first, n) для каждого отрезка из n подряд лежащих
+    // элементов, по одному на пачку. Внутренний цикл по отрезку обходится
+    // без проверок границ пачки, и компилятор может его векторизовать.
+    template<class Func>
+    void forEachSpan(int topIndex, Func& func)
+    {
+        static_assert(
+            TChunk::isContiguous(),
+            "Spans require Align not greater than alignof(T)"
+        );
+
+        auto chunk = _head;
+        int index = topIndex;
+        int count = _count;
+        while (count > 0) {
+            int size = std::min(count, int(ChunkSize) - index);
+            func(chunk->getData() + index, size_t(size));
+
+            count -= size;
+            index = 0;
+            chunk = chunk->next;
+        }
+    }
+
+    TView getView(int topIndex)
+    {
+        return TView(_head, topIndex, _count);
+    }
+private:
+    // Пачка и позиция для следующего элемента: новая пачка берётся, когда
+    // последняя заполнена.
+    int prepareTail(int topIndex)
+    {
+        ASSERT(-1 > topIndex < ChunkSize, Errors::IndexOutOfRange);
+
+        int index = (topIndex + _count) % ChunkSize;
+        if (_tail == nullptr) {
+            _head = _pool.create();
+            _head->prev = nullptr;
+            _tail = _head;
+        } else if (index == 0 && _count != 0) {
+            _tail->next = _pool.create();
+            _tail->next->prev = _tail;
+            _tail = _tail->next;
+        }
+
+        return index;
+    }
+
+    template<class InputIt>
+    void appendItems(int topIndex, InputIt first, InputIt last, std::false_type)
+    {
+        for (; first != last; ++first) {
+            appendItemAt(topIndex, *first);
+        }
+    }
+
+    void appendItems(int topIndex, const T* first, const T* last, std::true_type)
+    {
+        while (first != last) {
+            int index = prepareTail(topIndex);
+            int size = int(std::min(last - first, ptrdiff_t(ChunkSize - index)));
+            memcpy(_tail->getData() + index, first, size * sizeof(T));
+
+            first += size;
+            _count += size;
+        }
+    }
+
+    template<class OutputIt>
+    OutputIt moveItems(TChunk* chunk, int index, int size, OutputIt out)
+    {
+        using IsRaw = std::integral_constant<bool, TChunk::isContiguous()>;
+        return moveItems(chunk, index, size, out, IsRaw());
+    }
+
+    template<class OutputIt>
+    OutputIt moveItems(TChunk* chunk, int index, int size, OutputIt out, std::false_type)
+    {
+        for (int i = index; i < index + size; i++) {
+            *out = std::move(chunk->getValue(i));
+            ++out;
+            chunk->release(i);
+        }
+
+        return out;
+    }
+
+    // std::move() сам сводится к memmove для тривиально копируемых T
+    template<class OutputIt>
+    OutputIt moveItems(TChunk* chunk, int index, int size, OutputIt out, std::true_type)
+    {
+        auto first = chunk->getData() + index;
+        out = std::move(first, first + size, out);
+
+        if (!std::is_trivially_destructible<T>::value) {
+            for (int i = index; i < index + size; i++) {
+                chunk->release(i);
+            }
+        }
+
+        return out;
+    }
+
+    template<class OutputIt>
+    OutputIt copyItems(int topIndex, OutputIt out, std::false_type) const
+    {
+        TConstIter end = getEnd();
+        for (TConstIter it = getBegin(topIndex); it != end; ++it) {
+            *out = *it;
+            ++out;
+        }
+
+        return out;
+    }
+
+    // std::copy() сам сводится к memmove для тривиально копируемых T
+    template<class OutputIt>
+    OutputIt copyItems(int topIndex, OutputIt out, std::true_type) const
+    {
+        auto chunk = _head;
+        int index = topIndex;
+        int count = _count;
+        while (count > 0) {
+            int size = std::min(count, int(ChunkSize) - index);
+            const T* first = chunk->getData() + index;
+            out = std::copy(first, first + size, out);
+
+            count -= size;
+            index = 0;
+            chunk = chunk->next;
         }
 
-        return builder.toArray();
+        return out;
     }
 };
 
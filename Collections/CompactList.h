@@ -0,0 +1,506 @@
+﻿#ifndef COMPACTLIST_H
+#define COMPACTLIST_H
+
+#include <new>
+#include <utility>
+#include <stdint.h>
+#include <algorithm>
+#include <type_traits>
+
+#include "Consts.h"
+#include "../Arena.h"
+#include "../Align.h"
+#include "../Debug.h"
+#include "../Memory.h"
+#include "../Exception.h"
+
+namespace GreedyContainers {
+namespace Internal {
+
+//##############################################################################
+//
+// CompactSlNode, CompactDlNode
+//  Узлы, которые живут в Arena и ссылаются друг на друга 32 битными
+//  смещениями. Объект хранится сразу за ссылками.
+//
+//##############################################################################
+
+template<class T, class Links>
+struct CompactNode : Links
+{
+    static constexpr size_t getDataOffset()
+    {
+        return alignValue(sizeof(Links), alignof(T));
+    }
+
+    static constexpr size_t getAlign()
+    {
+        return std::max(ARENA_GRANULE, alignof(T));
+    }
+
+    static constexpr size_t getDataSize()
+    {
+        return alignValue(getDataOffset() + sizeof(T), getAlign());
+    }
+
+    T* value()
+    {
+        return Memory::ptrInc<T>(this, getDataOffset());
+    }
+};
+
+struct CompactSlLinks
+{
+    uint32_t next;
+};
+
+struct CompactDlLinks
+{
+    uint32_t next;
+    uint32_t prev;
+};
+
+template<class T>
+using CompactSlNode = CompactNode<T, CompactSlLinks>;
+
+template<class T>
+using CompactDlNode = CompactNode<T, CompactDlLinks>;
+
+//##############################################################################
+//
+// CompactNodePool
+//  Узлы берутся из арены, освобожденные узлы идут в список свободных.
+//  Память возвращается только вместе с ареной.
+//
+//##############################################################################
+
+template<class T, class NodeType>
+class CompactNodePool
+{
+public:
+    CompactNodePool(Arena& arena)
+    {
+        _top = 0;
+        _arena = &arena;
+    }
+
+    template<typename ...Args>
+    uint32_t create(Args&&... args)
+    {
+        uint32_t handle = _top;
+        NodeType* node = nullptr;
+
+        if (handle != 0) {
+            node = get(handle);
+        }
+        else {
+            node = static_cast<NodeType*>(
+                _arena->alloc(NodeType::getDataSize(), NodeType::getAlign())
+            );
+
+            handle = _arena->toOffset(node);
+
+            // узел уже принадлежит пулу, даже если конструктор упадет
+            node->next = 0;
+            _top = handle;
+        }
+
+        new (node->value()) T(std::forward<Args>(args)...);
+
+        _top = node->next;
+        return handle;
+    }
+
+    void release(uint32_t handle)
+    {
+        ASSERT(handle != 0);
+
+        auto node = get(handle);
+        node->value()->~T();
+        node->next = _top;
+        _top = handle;
+    }
+
+    NodeType* get(uint32_t handle) const
+    {
+        return static_cast<NodeType*>(_arena->fromOffset(handle));
+    }
+
+    Arena* arena() const
+    {
+        return _arena;
+    }
+private:
+    uint32_t _top;
+    Arena* _arena;
+};
+
+//##############################################################################
+//
+// CompactIter
+//
+//##############################################################################
+
+template<class T, class NodeType>
+class CompactIter
+{
+public:
+    CompactIter(const Arena* arena, uint32_t node)
+    {
+        _arena = arena;
+        _node = node;
+    }
+
+    bool operator != (CompactIter const& other) const
+    {
+        return _node != other._node;
+    }
+
+    CompactIter& operator++() {
+        _node = getNode()->next;
+        return *this;
+    }
+
+    T& operator*() const
+    {
+        return *getNode()->value();
+    }
+
+private:
+    const Arena* _arena;
+    uint32_t _node;
+
+    NodeType* getNode() const
+    {
+        return static_cast<NodeType*>(_arena->fromOffset(_node));
+    }
+};
+
+} // Internal end
+
+//##############################################################################
+//
+// CompactSlList
+//
+//##############################################################################
+
+template<class T>
+class CompactSlList
+{
+    using NodeType = Internal::CompactSlNode<T>;
+    using PoolType = Internal::CompactNodePool<T, NodeType>;
+
+    static_assert(
+        std::is_class<T>::value,
+        "Type parameter T must be a class type"
+    );
+public:
+    using Item = Handle<NodeType>;
+    using Iter = Internal::CompactIter<T, NodeType>;
+
+    CompactSlList(Arena& arena)
+        : _pool(arena)
+    {
+        initData();
+    }
+
+    ~CompactSlList()
+    {
+        releaseAll();
+    }
+
+    template<typename ...Args>
+    Item addFirst(Args&&... args)
+    {
+        auto handle = _pool.create(std::forward<Args>(args)...);
+        getNode(handle)->next = _first;
+        _first = handle;
+        if (_last == 0) {
+            _last = handle;
+        }
+
+        _count++;
+        return Item { handle };
+    }
+
+    template<typename ...Args>
+    Item addLast(Args&&... args)
+    {
+        auto handle = _pool.create(std::forward<Args>(args)...);
+        getNode(handle)->next = 0;
+        if (_last == 0) {
+            _first = handle;
+        }
+        else {
+            getNode(_last)->next = handle;
+        }
+
+        _last = handle;
+        _count++;
+        return Item { handle };
+    }
+
+    template<typename ...Args>
+    Item insertAfter(Item prev, Args&&... args)
+    {
+        ASSERT(!prev.isNull());
+
+        auto prevNode = getNode(prev.offset);
+        auto handle = _pool.create(std::forward<Args>(args)...);
+        getNode(handle)->next = prevNode->next;
+        prevNode->next = handle;
+        if (_last == prev.offset) {
+            _last = handle;
+        }
+
+        _count++;
+        return Item { handle };
+    }
+
+    void remove(Item item)
+    {
+        ASSERT(!item.isNull());
+
+        uint32_t prev = 0;
+        uint32_t current = _first;
+        while (current != item.offset) {
+            if (current == 0) {
+                RAISE(ArgumentException, Internal::Errors::UnknownNode);
+            }
+
+            prev = current;
+            current = getNode(current)->next;
+        }
+
+        auto next = getNode(current)->next;
+        if (prev == 0) {
+            _first = next;
+        }
+        else {
+            getNode(prev)->next = next;
+        }
+
+        if (_last == current) {
+            _last = prev;
+        }
+
+        _pool.release(current);
+        _count--;
+    }
+
+    T* get(Item item) const
+    {
+        ASSERT(!item.isNull());
+        return getNode(item.offset)->value();
+    }
+
+    void clear()
+    {
+        releaseAll();
+        initData();
+    }
+
+    size_t count() const
+    {
+        return _count;
+    }
+
+    Iter begin() const
+    {
+        return Iter(_pool.arena(), _first);
+    }
+
+    Iter end() const
+    {
+        return Iter(_pool.arena(), 0);
+    }
+private:
+    uint32_t _first;
+    uint32_t _last;
+    size_t _count;
+    PoolType _pool;
+
+    CompactSlList(const CompactSlList&) = delete;
+    CompactSlList& operator = (const CompactSlList&) = delete;
+
+    NodeType* getNode(uint32_t handle) const
+    {
+        return _pool.get(handle);
+    }
+
+    void initData()
+    {
+        _first = 0;
+        _last = 0;
+        _count = 0;
+    }
+
+    void releaseAll()
+    {
+        auto current = _first;
+        while (current) {
+            auto next = getNode(current)->next;
+            _pool.release(current);
+            current = next;
+        }
+    }
+};
+
+//##############################################################################
+//
+// CompactDlList
+//
+//##############################################################################
+
+template<class T>
+class CompactDlList
+{
+    using NodeType = Internal::CompactDlNode<T>;
+    using PoolType = Internal::CompactNodePool<T, NodeType>;
+
+    static_assert(
+        std::is_class<T>::value,
+        "Type parameter T must be a class type"
+    );
+public:
+    using Item = Handle<NodeType>;
+    using Iter = Internal::CompactIter<T, NodeType>;
+
+    CompactDlList(Arena& arena)
+        : _pool(arena)
+    {
+        initData();
+    }
+
+    ~CompactDlList()
+    {
+        releaseAll();
+    }
+
+    template<typename ...Args>
+    Item addFirst(Args&&... args)
+    {
+        return Item { insertNode(0, _first, std::forward<Args>(args)...) };
+    }
+
+    template<typename ...Args>
+    Item addLast(Args&&... args)
+    {
+        return Item { insertNode(_last, 0, std::forward<Args>(args)...) };
+    }
+
+    template<typename ...Args>
+    Item insertBefore(Item next, Args&&... args)
+    {
+        ASSERT(!next.isNull());
+        auto prev = getNode(next.offset)->prev;
+        return Item { insertNode(prev, next.offset, std::forward<Args>(args)...) };
+    }
+
+    template<typename ...Args>
+    Item insertAfter(Item prev, Args&&... args)
+    {
+        ASSERT(!prev.isNull());
+        auto next = getNode(prev.offset)->next;
+        return Item { insertNode(prev.offset, next, std::forward<Args>(args)...) };
+    }
+
+    void remove(Item item)
+    {
+        ASSERT(!item.isNull());
+
+        auto node = getNode(item.offset);
+        connectNodes(node->prev, node->next);
+        _pool.release(item.offset);
+        _count--;
+    }
+
+    T* get(Item item) const
+    {
+        ASSERT(!item.isNull());
+        return getNode(item.offset)->value();
+    }
+
+    void clear()
+    {
+        releaseAll();
+        initData();
+    }
+
+    size_t count() const
+    {
+        return _count;
+    }
+
+    Iter begin() const
+    {
+        return Iter(_pool.arena(), _first);
+    }
+
+    Iter end() const
+    {
+        return Iter(_pool.arena(), 0);
+    }
+private:
+    uint32_t _first;
+    uint32_t _last;
+    size_t _count;
+    PoolType _pool;
+
+    CompactDlList(const CompactDlList&) = delete;
+    CompactDlList& operator = (const CompactDlList&) = delete;
+
+    NodeType* getNode(uint32_t handle) const
+    {
+        return _pool.get(handle);
+    }
+
+    void initData()
+    {
+        _first = 0;
+        _last = 0;
+        _count = 0;
+    }
+
+    template<typename ...Args>
+    uint32_t insertNode(uint32_t prev, uint32_t next, Args&&... args)
+    {
+        auto handle = _pool.create(std::forward<Args>(args)...);
+        connectNodes(prev, handle);
+        connectNodes(handle, next);
+        _count++;
+        return handle;
+    }
+
+    // нулевой handle слева или справа означает начало или конец списка
+    void connectNodes(uint32_t first, uint32_t second)
+    {
+        if (first == 0) {
+            _first = second;
+        }
+        else {
+            getNode(first)->next = second;
+        }
+
+        if (second == 0) {
+            _last = first;
+        }
+        else {
+            getNode(second)->prev = first;
+        }
+    }
+
+    void releaseAll()
+    {
+        auto current = _first;
+        while (current) {
+            auto next = getNode(current)->next;
+            _pool.release(current);
+            current = next;
+        }
+    }
+};
+
+}
+
+#endif // COMPACTLIST_H
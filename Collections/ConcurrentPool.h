@@ -0,0 +1,426 @@
+﻿#ifndef CONCURRENTPOOL_H
+#define CONCURRENTPOOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <stdint.h>
+#include <algorithm>
+
+#include "Consts.h"
+#include "Nodes.h"
+#include "AllocTraits.h"
+#include "../Align.h"
+#include "../Debug.h"
+#include "../Memory.h"
+#include "../Exception.h"
+
+namespace GreedyContainers {
+namespace Internal {
+
+inline uint64_t nextConcurrentPoolId()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+class ThreadCacheOwner;
+
+// Часть кэша ConcurrentNodePool, по которой его открепляет поток.
+struct OwnedCache
+{
+    std::atomic<std::thread::id> thread;
+    // соседи в списке кэшей потока, под ThreadCacheOwner::getLock()
+    OwnedCache* prevOwned;
+    OwnedCache* nextOwned;
+    ThreadCacheOwner* owner;
+};
+
+// Последний пул, с которым работал поток, и его кэш в этом пуле. Один на
+// все пулы: id пулов не повторяются.
+struct ConcurrentThreadSlot
+{
+    uint64_t poolId;
+    OwnedCache* cache;
+    // поток завершается, новые кэши за ним не закрепляются
+    bool finished;
+};
+
+inline ConcurrentThreadSlot& concurrentThreadSlot()
+{
+    static thread_local ConcurrentThreadSlot slot = {0, nullptr, false};
+    return slot;
+}
+
+//##############################################################################
+//
+// ThreadCacheOwner
+//  Кэши всех ConcurrentNodePool, закреплённые за потоком. При завершении
+//  потока открепляет их, как detachThread(), иначе кэш оставался бы за
+//  мёртвым потоком вместе со свободными узлами. Списки меняются под общим
+//  мьютексом; его берут только закрепление и открепление кэша, завершение
+//  потока и разрушение пула. Кэш, который поток закрепил в деструкторе
+//  другого thread_local уже после этого, остаётся за ним.
+//
+//##############################################################################
+
+class ThreadCacheOwner
+{
+public:
+    ThreadCacheOwner()
+    {
+        _head = nullptr;
+    }
+
+    ~ThreadCacheOwner()
+    {
+        std::lock_guard<std::mutex> guard(getLock());
+
+        while (_head) {
+            auto cache = _head;
+            remove(cache);
+            cache->thread.store(std::thread::id(), std::memory_order_release);
+        }
+
+        auto& slot = concurrentThreadSlot();
+        slot.poolId = 0;
+        slot.cache = nullptr;
+        slot.finished = true;
+    }
+
+    static std::mutex& getLock()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+
+    // Закрепляет cache за текущим потоком, под getLock().
+    static void add(OwnedCache* cache)
+    {
+        if (concurrentThreadSlot().finished) {
+            return;
+        }
+
+        static thread_local ThreadCacheOwner current;
+
+        cache->owner = &current;
+        cache->prevOwned = nullptr;
+        cache->nextOwned = current._head;
+        if (current._head) {
+            current._head->prevOwned = cache;
+        }
+
+        current._head = cache;
+    }
+
+    // Убирает cache из списка его потока, под getLock().
+    static void remove(OwnedCache* cache)
+    {
+        auto owner = cache->owner;
+        if (owner == nullptr) {
+            return;
+        }
+
+        if (cache->prevOwned) {
+            cache->prevOwned->nextOwned = cache->nextOwned;
+        } else {
+            owner->_head = cache->nextOwned;
+        }
+
+        if (cache->nextOwned) {
+            cache->nextOwned->prevOwned = cache->prevOwned;
+        }
+
+        cache->prevOwned = nullptr;
+        cache->nextOwned = nullptr;
+        cache->owner = nullptr;
+    }
+private:
+    OwnedCache* _head;
+
+    ThreadCacheOwner(const ThreadCacheOwner&) = delete;
+};
+
+//##############################################################################
+//
+// ConcurrentNodePool
+//  Пул узлов, которым одновременно пользуются несколько потоков. У каждого
+//  потока свой кэш (магазин) узлов и своя пачка для нарезки, поэтому
+//  create() и release() своего узла обходятся без блокировок. Узел,
+//  освобождённый чужим потоком, уходит в lock-free список кэша-владельца
+//  и забирается им целиком при следующей нехватке узлов.
+//
+//  Аллокатор вызывается только под мьютексом пула. Кэш закрепляется за
+//  потоком при первом create() и живёт, пока жив пул; detachThread() или
+//  завершение потока отдают его другому потоку. shrink() не поддерживается.
+//
+//##############################################################################
+
+template<class NodeType, class Allocator>
+class ConcurrentNodePool
+{
+    struct ThreadCache;
+
+    // Заголовок перед каждым узлом: кэш, из пачки которого узел нарезан.
+    struct NodeHeader
+    {
+        ThreadCache* owner;
+    };
+
+    struct ThreadCache : OwnedCache
+    {
+        ThreadCache* next;
+        // свободные узлы, доступны только своему потоку
+        NodeType* top;
+        void* cursor;
+        void* cursorEnd;
+        size_t growSize;
+        // узлы, освобождённые чужими потоками; в отдельной строке кэша,
+        // чтобы чужие release() не мешали create() владельца
+        alignas(CACHE_LINE_SIZE) std::atomic<NodeType*> remote;
+    };
+public:
+    ConcurrentNodePool(Allocator& allocator, size_t chunkSize, size_t)
+    {
+        _id = nextConcurrentPoolId();
+        _allocator = &allocator;
+        _chunks = nullptr;
+        _caches.store(nullptr);
+
+        _chunkSize = chunkSize;
+        _chunkSize = std::max(_chunkSize, MIN_CHUNK_SIZE);
+        _chunkSize = std::min(_chunkSize, MAX_CHUNK_SIZE);
+    }
+
+    // Перемещать можно, только когда пулом никто не пользуется.
+    ConcurrentNodePool(ConcurrentNodePool&& src)
+    {
+        _id = src._id;
+        _allocator = src._allocator;
+        _chunks = src._chunks;
+        _chunkSize = src._chunkSize;
+        _caches.store(src._caches.load());
+
+        src._id = nextConcurrentPoolId();
+        src._chunks = nullptr;
+        src._caches.store(nullptr);
+    }
+
+    ~ConcurrentNodePool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(ThreadCacheOwner::getLock());
+            for (auto cache = _caches.load(); cache; cache = cache->next) {
+                ThreadCacheOwner::remove(cache);
+            }
+        }
+
+        if (!HasFree<Allocator>::value) {
+            return;
+        }
+
+        auto chunk = _chunks;
+        while (chunk) {
+            auto next = chunk->next;
+            freeMemory(*_allocator, chunk);
+            chunk = next;
+        }
+
+        auto cache = _caches.load();
+        while (cache) {
+            auto next = cache->next;
+            cache->~ThreadCache();
+            freeMemory(*_allocator, cache);
+            cache = next;
+        }
+    }
+
+    template<typename ...Args>
+    NodeType* create(Args&&... args)
+    {
+        auto cache = getCache(true);
+
+        auto result = cache->top;
+        if (result == nullptr) {
+            result = cache->remote.exchange(nullptr, std::memory_order_acquire);
+            cache->top = result;
+        }
+
+        if (result == nullptr) {
+            if (cache->cursor == cache->cursorEnd) {
+                allocChunk(cache);
+            }
+
+            result = Memory::ptrInc<NodeType>(cache->cursor, HEADER_SIZE);
+        }
+
+        // In order not to damage internal states when exception raised, it
+        // is necessary to call the client's constructor first.
+        result->init(std::forward<Args>(args)...);
+
+        if (result == cache->top) {
+            cache->top = result->next;
+        } else {
+            getHeader(result)->owner = cache;
+            cache->cursor = Memory::ptrInc(cache->cursor, getSlotSize());
+        }
+
+        return result;
+    }
+
+    // Можно вызывать из любого потока.
+    void release(NodeType* node)
+    {
+        CHECK_NULL_ARG(node);
+
+        node->release();
+
+        auto owner = getHeader(node)->owner;
+        if (owner == getCache(false)) {
+            node->next = owner->top;
+            owner->top = node;
+            return;
+        }
+
+        NodeType* head = owner->remote.load(std::memory_order_relaxed);
+        do {
+            node->next = head;
+        } while (!owner->remote.compare_exchange_weak(
+            head, node, std::memory_order_release, std::memory_order_relaxed
+        ));
+    }
+
+    // Открепляет кэш текущего потока. Его свободные узлы достанутся
+    // потоку, который закрепит кэш следующим.
+    void detachThread()
+    {
+        auto cache = getCache(false);
+        if (cache == nullptr) {
+            return;
+        }
+
+        concurrentThreadSlot().cache = nullptr;
+
+        std::lock_guard<std::mutex> guard(ThreadCacheOwner::getLock());
+        ThreadCacheOwner::remove(cache);
+        cache->thread.store(std::thread::id(), std::memory_order_release);
+    }
+private:
+    // заголовок сохраняет выравнивание узла
+    static const size_t HEADER_SIZE = alignValue(
+        sizeof(NodeHeader), maxAlign(NodeType::getAlign(), DEFAULT_ALIGN)
+    );
+
+    uint64_t _id;
+    size_t _chunkSize;
+    Allocator* _allocator;
+    std::mutex _lock;
+    // все пачки всех кэшей, под _lock
+    NodeChunk* _chunks;
+    // кэши только добавляются, поэтому их можно обходить без блокировки
+    std::atomic<ThreadCache*> _caches;
+
+    static constexpr size_t getSlotSize() {
+        return HEADER_SIZE + NodeType::getDataSize();
+    }
+
+    static NodeHeader* getHeader(NodeType* node)
+    {
+        return reinterpret_cast<NodeHeader*>(
+            reinterpret_cast<uint8_t*>(node) - HEADER_SIZE
+        );
+    }
+
+    ThreadCache* getCache(bool attach)
+    {
+        // поток без кэша тоже запоминается, чтобы его release() не искал
+        // кэш каждый раз
+        auto& slot = concurrentThreadSlot();
+        if (slot.poolId == _id && (slot.cache || !attach)) {
+            return static_cast<ThreadCache*>(slot.cache);
+        }
+
+        auto current = std::this_thread::get_id();
+        auto cache = _caches.load(std::memory_order_acquire);
+        while (cache) {
+            if (cache->thread.load(std::memory_order_relaxed) == current) {
+                break;
+            }
+
+            cache = cache->next;
+        }
+
+        if (cache == nullptr && attach) {
+            cache = attachCache(current);
+        }
+
+        slot.poolId = _id;
+        slot.cache = cache;
+        return cache;
+    }
+
+    ThreadCache* attachCache(std::thread::id current)
+    {
+        auto cache = _caches.load(std::memory_order_acquire);
+        while (cache) {
+            std::thread::id none;
+            if (cache->thread.compare_exchange_strong(none, current)) {
+                std::lock_guard<std::mutex> guard(ThreadCacheOwner::getLock());
+                ThreadCacheOwner::add(cache);
+                return cache;
+            }
+
+            cache = cache->next;
+        }
+
+        std::lock_guard<std::mutex> guard(_lock);
+
+        cache = reinterpret_cast<ThreadCache*>(
+            _allocator->alloc(alignValue(sizeof(ThreadCache), CACHE_LINE_SIZE), CACHE_LINE_SIZE)
+        );
+        CHECK_NULL_PTR(cache);
+
+        new (cache) ThreadCache();
+        cache->thread.store(current);
+        cache->top = nullptr;
+        cache->cursor = nullptr;
+        cache->cursorEnd = nullptr;
+        cache->growSize = _chunkSize;
+        cache->remote.store(nullptr);
+        cache->owner = nullptr;
+
+        {
+            std::lock_guard<std::mutex> ownerGuard(ThreadCacheOwner::getLock());
+            ThreadCacheOwner::add(cache);
+        }
+
+        cache->next = _caches.load(std::memory_order_relaxed);
+        _caches.store(cache, std::memory_order_release);
+        return cache;
+    }
+
+    void allocChunk(ThreadCache* cache)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+
+        auto size = cache->growSize;
+        auto align = NodeType::getAlign();
+        auto chunk = reinterpret_cast<NodeChunk*>(_allocator->alloc(
+            NodeChunk::getHeaderSize(align) + size * getSlotSize(), align
+        ));
+        CHECK_NULL_PTR(chunk);
+
+        chunk->size = size;
+        chunk->next = _chunks;
+        _chunks = chunk;
+
+        cache->cursor = chunk->begin(align);
+        cache->cursorEnd = chunk->end(getSlotSize(), align);
+        cache->growSize = std::min(size * 2, MAX_CHUNK_SIZE);
+    }
+};
+
+}
+}
+
+#endif // CONCURRENTPOOL_H
@@ -4,17 +4,34 @@
 #include <stdint.h>
 
 namespace GreedyContainers {
+
+    // размер строки кэша; как параметр Align контейнеров разносит элементы,
+    // с которыми работают разные потоки, по разным строкам
+    const static size_t CACHE_LINE_SIZE = 64;
+
 namespace Internal {
 
+    constexpr size_t maxAlign(size_t a, size_t b)
+    {
+        return a > b ? a : b;
+    }
+
     // минимальный размер пачки
     const static size_t MIN_CHUNK_SIZE = 3;
-    // максимальный размер пачки
-    const static size_t MAX_CHUNK_SIZE = 50;
+    // максимальный размер пачки узлов: пачки растут вдвое от заданного
+    // размера до этого предела
+    const static size_t MAX_CHUNK_SIZE = 8192;
 
     // размер предварительной пачки
     const static size_t DEF_CAPACITY = 3;
-    // размер пачки по умолчанию
-    const static size_t DEF_CHUNK_SIZE = 5;
+    // размер пачки по умолчанию у ObjHolder, ObjQueue, ObjStack и Ptr...:
+    // подбирается по sizeof(T), см. autoChunkSize()
+    const static size_t AUTO_CHUNK_SIZE = 0;
+    // сколько байт занимает пачка с автоматическим размером
+    const static size_t AUTO_CHUNK_BYTES = 1024;
+    // во сколько пачек, не больше, вырастает блок, которым ChunkPool
+    // берёт память у аллокатора
+    const static uint32_t MAX_CHUNK_RESERVE = 64;
 
 
     namespace Errors {
@@ -28,6 +45,14 @@ namespace Internal {
                 "Container is moved";
         static const char* IndexOutOfRange =
                 "Index out of range";
+        static const char* ForeignPool =
+                "Lists do not share node pool";
+        static const char* UnknownItem =
+                "Item not exist in container";
+        static const char* SameList =
+                "Source list is the target list";
+        static const char* ReleasedNode =
+                "Node is already released";
     }
 }
 }
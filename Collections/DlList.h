@@ -12,16 +12,24 @@
 namespace GreedyContainers {
 namespace Internal {
 
-template<class T, class Allocator>
+template<class T, class Allocator, template<class, class> class Pool,
+         size_t Align = alignof(T)>
 class BaseDoubleLinkedList
 {
 public:
-    using NodeType = DlNode<T>;
-    using NodeAllocatorType = NodePool<NodeType, Allocator>;
+    using NodeType = DlNode<T, Align>;
+    using NodeAllocatorType = Pool<NodeType, Allocator>;
+    using NodePoolType = NodePool<NodeType, Allocator>;
     using ItemHelperType = ItemHelper<T, NodeType>;
+    using DetachedHelperType = DetachedHelper<T, NodeType, NodeAllocatorType>;
 public:
-    using IterType = DlIterForward<T>;
+    using IterType = DlIter<T, Align>;
+    using ConstIterType = DlIter<T, Align, true>;
+    using ReverseIterType = std::reverse_iterator<IterType>;
+    using ConstReverseIterType = std::reverse_iterator<ConstIterType>;
+    using PrefetchIterType = DlIter<T, Align, false, true>;
     using ItemType = Item<T, NodeType>;
+    using DetachedType = DetachedNode<T, NodeType, NodeAllocatorType>;
 
     ~BaseDoubleLinkedList()
     {
@@ -34,17 +42,197 @@ public:
         ItemHelperType::release(item);
     }
 
+    // Добавляет узел, созданный make(). Узел при этом не выделяется,
+    // поэтому с ConcurrentNodePool make() можно вызывать вне блокировки
+    // списка, а под ней - только attach...().
+    ItemType attachFirst(DetachedType&& detached)
+    {
+        auto node = DetachedHelperType::take(detached);
+        linkNode(&_head, _head.next, node);
+        return ItemHelperType::make(node);
+    }
+
+    ItemType attachLast(DetachedType&& detached)
+    {
+        auto node = DetachedHelperType::take(detached);
+        linkNode(_tail.prev, &_tail, node);
+        return ItemHelperType::make(node);
+    }
+
+    // Исключает элемент из списка, не освобождая узел. Узел вернётся в
+    // пул, когда будет уничтожен результат.
+    DetachedType detach(ItemType& item)
+    {
+        auto node = ItemHelperType::getNode(item);
+        checkNode(node);
+        unlinkNode(node);
+        ItemHelperType::release(item);
+        return DetachedHelperType::make(node, &_nodeAllocator);
+    }
+
+    DetachedType detachFirst()
+    {
+        if (_count == 0) {
+            RAISE(RuntimeException, Errors::EmptyContainer);
+        }
+
+        auto node = _head.next;
+        unlinkNode(node);
+        return DetachedHelperType::make(node, &_nodeAllocator);
+    }
+
     void clear()
     {
         releaseAll();
         initData();
     }
 
-    size_t count()
+    size_t count() const
     {
         return _count;
     }
 
+    // Возвращает аллокатору пачки узлов, в которых не осталось элементов.
+    size_t shrink()
+    {
+        return _nodeAllocator.shrink();
+    }
+
+    void setAutoTrim(bool enabled)
+    {
+        _nodeAllocator.setAutoTrim(enabled);
+    }
+
+    // Перенос и слияние только перецепляют узлы, поэтому доступны для
+    // списков с общим пулом (SharedNodePool).
+
+    // Переносит все элементы other в конец списка за O(1).
+    void spliceAll(BaseDoubleLinkedList& other)
+    {
+        checkPool(other);
+        if (&other == this || other._count == 0) {
+            return;
+        }
+
+        connectNodes(_tail.prev, other._head.next);
+        connectNodes(other._tail.prev, &_tail);
+        _count += other._count;
+        other.initData();
+    }
+
+    // Переносит элемент из other в конец списка за O(1), item остаётся
+    // действительным. Что item принадлежит other, проверяется обходом other
+    // только в Debug; в Release элемент третьего списка портит счётчики.
+    void splice(ItemType& item, BaseDoubleLinkedList& other)
+    {
+        checkPool(other);
+
+        auto node = ItemHelperType::getNode(item);
+
+#ifdef DEBUG
+        other.checkNode(node);
+#endif
+
+        other.unlinkNode(node);
+        linkNode(_tail.prev, &_tail, node);
+    }
+
+    // Переносит элементы от first до last включительно из другого списка
+    // other в конец списка. Узлы не пересоздаются, время - O(кол-во
+    // элементов). Что first принадлежит other, проверяется обходом other
+    // только в Debug; в Release диапазон из третьего списка портит счётчики
+    // обоих списков.
+    void splice(ItemType& first, ItemType& last, BaseDoubleLinkedList& other)
+    {
+        checkPool(other);
+        if (&other == this) {
+            RAISE(ArgumentException, Errors::SameList);
+        }
+
+        auto firstNode = ItemHelperType::getNode(first);
+        auto lastNode = ItemHelperType::getNode(last);
+
+#ifdef DEBUG
+        other.checkNode(firstNode);
+#endif
+
+        // last должен идти после first; дошли до хвоста - не дошли до last
+        size_t count = 1;
+        for (auto node = firstNode; node != lastNode; node = node->next) {
+            if (node->next == nullptr) {
+                RAISE(ArgumentException, Errors::UnknownNode);
+            }
+
+            count++;
+        }
+
+        connectNodes(firstNode->prev, lastNode->next);
+        other._count -= count;
+
+        connectNodes(_tail.prev, firstNode);
+        connectNodes(lastNode, &_tail);
+        _count += count;
+    }
+
+    // Сливает в список отсортированный список other, оба упорядочены по
+    // less(a, b), который получает указатели на значения. Слияние
+    // устойчивое, без выделения памяти, O(n + m). other становится пустым.
+    template<class Less>
+    void merge(BaseDoubleLinkedList& other, Less less)
+    {
+        checkPool(other);
+        if (&other == this) {
+            return;
+        }
+
+        auto current = _head.next;
+        auto node = other._head.next;
+        while (node != &other._tail) {
+            if (current == &_tail) {
+                connectNodes(_tail.prev, node);
+                connectNodes(other._tail.prev, &_tail);
+                break;
+            }
+
+            if (less(node->getValue(), current->getValue())) {
+                auto next = node->next;
+                connectNodes(current->prev, node);
+                connectNodes(node, current);
+                node = next;
+            } else {
+                current = current->next;
+            }
+        }
+
+        _count += other._count;
+        other.initData();
+    }
+
+    // Сортирует список по less(a, b), который получает указатели на
+    // значения. Сортировка слиянием по связям узлов: устойчивая, без
+    // выделения памяти, O(n log n). Item остаются действительными.
+    template<class Less>
+    void sort(Less less)
+    {
+        if (_count < 2) {
+            return;
+        }
+
+        _tail.prev->next = nullptr;
+        auto first = sortChain(_head.next, [&](NodeType* a, NodeType* b) {
+            return less(a->getValue(), b->getValue());
+        });
+
+        // после слияния верны только связи next
+        auto prev = &_head;
+        for (auto node = first; node; node = node->next) {
+            connectNodes(prev, node);
+            prev = node;
+        }
+
+        connectNodes(prev, &_tail);
+    }
+
     IterType begin()
     {
         return _head.next;
@@ -54,6 +242,63 @@ public:
     {
         return &_tail;
     }
+
+    ConstIterType begin() const
+    {
+        return _head.next;
+    }
+
+    ConstIterType end() const
+    {
+        return const_cast<NodeType*>(&_tail);
+    }
+
+    ConstIterType cbegin() const
+    {
+        return begin();
+    }
+
+    ConstIterType cend() const
+    {
+        return end();
+    }
+
+    ReverseIterType rbegin()
+    {
+        return ReverseIterType(end());
+    }
+
+    ReverseIterType rend()
+    {
+        return ReverseIterType(begin());
+    }
+
+    ConstReverseIterType rbegin() const
+    {
+        return ConstReverseIterType(end());
+    }
+
+    ConstReverseIterType rend() const
+    {
+        return ConstReverseIterType(begin());
+    }
+
+    ConstReverseIterType crbegin() const
+    {
+        return rbegin();
+    }
+
+    ConstReverseIterType crend() const
+    {
+        return rend();
+    }
+
+    // Обход с упреждающей загрузкой следующего узла, для списков, чьи
+    // узлы разбросаны по памяти: for (auto& value : list.prefetched()).
+    IterRange<PrefetchIterType> prefetched()
+    {
+        return {_head.next, &_tail};
+    }
 protected:
     BaseDoubleLinkedList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : _nodeAllocator(allocator, chunkSize, capacity)
@@ -61,13 +306,17 @@ protected:
         initData();
     }
 
+    explicit BaseDoubleLinkedList(NodePoolType& pool)
+        : _nodeAllocator(pool)
+    {
+        initData();
+    }
+
     BaseDoubleLinkedList(BaseDoubleLinkedList&& src)
         : _nodeAllocator(std::move(src._nodeAllocator))
     {
         _head.prev = nullptr;
-        _head.value = nullptr;
         _tail.next = nullptr;
-        _tail.value = nullptr;
         _count = src._count;
 
         auto srcHead = &src._head;
@@ -111,6 +360,13 @@ protected:
         return ItemHelperType::make(node);
     }
 
+    template<typename ...Args>
+    DetachedType doMake(Args&&... args)
+    {
+        auto node = _nodeAllocator.create(std::forward<Args>(args)...);
+        return DetachedHelperType::make(node, &_nodeAllocator);
+    }
+
 private:
     size_t _count;
     NodeType _head;
@@ -123,11 +379,9 @@ private:
 
         _head.prev = nullptr;
         _head.next = &_tail;
-        _head.value = nullptr;
 
         _tail.prev = &_head;
         _tail.next = nullptr;
-        _tail.value = nullptr;
     }
 
     template<typename ...Args>
@@ -138,23 +392,38 @@ private:
         checkNode(prev);
 
         auto node = _nodeAllocator.create(std::forward<Args>(args)...);
+        linkNode(prev, next, node);
+
+        return node;
+    }
+
+    void linkNode(NodeType* prev, NodeType* next, NodeType* node)
+    {
         connectNodes(prev, node);
         connectNodes(node, next);
         _count++;
+    }
 
-        return node;
+    void unlinkNode(NodeType* node)
+    {
+        ASSERT(node->prev != nullptr && node->next != nullptr);
+
+        connectNodes(node->prev, node->next);
+        _count--;
     }
 
     void removeNode(NodeType* node)
     {
-        ASSERT(node->prev != nullptr && node->next != nullptr);
         checkNode(node);
-
-        auto prev = node->prev;
-        auto next = node->next;
+        unlinkNode(node);
         _nodeAllocator.release(node);
-        connectNodes(prev, next);
-        _count--;
+    }
+
+    void checkPool(BaseDoubleLinkedList& other)
+    {
+        if (!_nodeAllocator.isSame(other._nodeAllocator)) {
+            RAISE(ArgumentException, Errors::ForeignPool);
+        }
     }
 
     void connectNodes(NodeType* first, NodeType* second)
@@ -170,7 +439,9 @@ private:
     {
         ASSERT(node != nullptr);
 
-        if (node == &_head || node == &_tail) {
+        // крайние узлы принадлежат списку без обхода, поэтому addFirst()
+        // и addLast() остаются O(1)
+        if (node == &_head || node == &_tail || node == _head.next || node == _tail.prev) {
             return;
         }
 
@@ -205,10 +476,11 @@ private:
 //
 //##############################################################################
 
-template<class T, class Allocator>
-class DlObjList : public Internal::BaseDoubleLinkedList<T, Allocator>
+template<class T, class Allocator, template<class, class> class Pool = Internal::NodePool,
+         size_t Align = alignof(T)>
+class DlObjList : public Internal::BaseDoubleLinkedList<T, Allocator, Pool, Align>
 {
-    using Parent = Internal::BaseDoubleLinkedList<T, Allocator>;
+    using Parent = Internal::BaseDoubleLinkedList<T, Allocator, Pool, Align>;
 
     static_assert(
         std::is_class<T>::value,
@@ -217,11 +489,26 @@ class DlObjList : public Internal::BaseDoubleLinkedList<T, Allocator>
 public:
     using Item = typename Parent::ItemType;
     using Iter = typename Parent::IterType;
+    using ConstIter = typename Parent::ConstIterType;
+    using ReverseIter = typename Parent::ReverseIterType;
+    using Node = typename Parent::DetachedType;
+    using NodePoolType = typename Parent::NodePoolType;
 
     DlObjList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : Parent(allocator, chunkSize, capacity)
     {}
 
+    // Только с Pool = SharedNodePool.
+    explicit DlObjList(NodePoolType& pool)
+        : Parent(pool)
+    {}
+
+    template<typename ...Args>
+    Node make(Args&&... args)
+    {
+        return this->doMake(std::forward<Args>(args)...);
+    }
+
     template<typename ...Args>
     Item addFirst(Args&&... args)
     {
@@ -253,10 +540,10 @@ public:
 //
 //##############################################################################
 
-template<class T, class Allocator>
-class DlPtrList: public Internal::BaseDoubleLinkedList<T*, Allocator>
+template<class T, class Allocator, template<class, class> class Pool = Internal::NodePool>
+class DlPtrList: public Internal::BaseDoubleLinkedList<T*, Allocator, Pool>
 {
-    using Parent = Internal::BaseDoubleLinkedList<T*, Allocator>;
+    using Parent = Internal::BaseDoubleLinkedList<T*, Allocator, Pool>;
 
     static_assert(
         std::is_class<T>::value,
@@ -265,11 +552,25 @@ class DlPtrList: public Internal::BaseDoubleLinkedList<T*, Allocator>
 public:
     using Item = typename Parent::ItemType;
     using Iter = typename Parent::IterType;
+    using ConstIter = typename Parent::ConstIterType;
+    using ReverseIter = typename Parent::ReverseIterType;
+    using Node = typename Parent::DetachedType;
+    using NodePoolType = typename Parent::NodePoolType;
 
     DlPtrList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : Parent(allocator, chunkSize, capacity)
     {}
 
+    // Только с Pool = SharedNodePool.
+    explicit DlPtrList(NodePoolType& pool)
+        : Parent(pool)
+    {}
+
+    Node make(T* value)
+    {
+        return this->doMake(value);
+    }
+
     Item addFirst(T* value)
     {
         return this->doAddFirst(value);
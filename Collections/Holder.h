@@ -1,50 +1,1031 @@
 ﻿#ifndef HOLDER_H
 #define HOLDER_H
 
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+
 #include "Chunks.h"
+#include "../Bits.h"
 
 namespace GreedyContainers {
 namespace Internal {
 
 //##############################################################################
 //
-// ChunkedStack
+// HolderSlots
+//  Занятость слотов пачки holder: бит на слот и связи списка пачек
+//  с дырами, из которого add() берёт место в первую очередь. Лежит сразу
+//  за пачкой, в запасе её шага, см. ChunkPool::setChunkStride(). Пока
+//  в пачке нет дыр, биты не ведутся: заняты все слоты до limit - конца
+//  заполненной части пачки. Поэтому добавление в конец их не трогает.
+//
+//##############################################################################
+
+template<class TChunk, size_t ChunkSize>
+struct HolderSlots
+{
+    static const size_t WORD_COUNT = (ChunkSize + 63) / 64;
+
+    uint64_t used[WORD_COUNT];
+    // соседи в списке пачек с дырами
+    TChunk* nextHoled;
+    TChunk* prevHoled;
+    // удалённые элементы пачки
+    uint32_t holeCount;
+
+    static HolderSlots* of(TChunk* chunk)
+    {
+        return reinterpret_cast<HolderSlots*>(
+            reinterpret_cast<uint8_t*>(chunk) + sizeof(TChunk)
+        );
+    }
+
+    void reset()
+    {
+        memset(used, 0, sizeof(used));
+        nextHoled = nullptr;
+        prevHoled = nullptr;
+        holeCount = 0;
+    }
+
+    bool isUsed(int index) const
+    {
+        return (used[index / 64] >> (index % 64)) & 1;
+    }
+
+    void setUsed(int index)
+    {
+        used[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    void setFree(int index)
+    {
+        used[index / 64] &= ~(uint64_t(1) << (index % 64));
+    }
+
+    // Отмечает занятыми слоты [first, last).
+    void setUsed(int first, int last)
+    {
+        for (int word = first / 64; word * 64 < last; word++) {
+            int from = std::max(first - word * 64, 0);
+            int to = std::min(last - word * 64, 64);
+            used[word] |= lowBitsMask(to) & ~lowBitsMask(from);
+        }
+    }
+
+    // Занятые слоты после index в его слове, только для пачки с дырами.
+    uint64_t usedAfter(int index) const
+    {
+        return used[index / 64] & ~lowBitsMask(index % 64 + 1);
+    }
+
+    // Первый занятый слот не раньше from или -1.
+    int findUsed(int from, int limit) const
+    {
+        if (holeCount == 0) {
+            return from < limit ? from : -1;
+        }
+
+        size_t word = from / 64;
+        if (word >= WORD_COUNT) {
+            return -1;
+        }
+
+        uint64_t bits = used[word] & ~lowBitsMask(from % 64);
+        while (bits == 0) {
+            if (++word == WORD_COUNT) {
+                return -1;
+            }
+
+            bits = used[word];
+        }
+
+        return int(word * 64) + countTrailingZeros(bits);
+    }
+
+    // Первый свободный слот не раньше from или ChunkSize.
+    int findFree(int from, int limit) const
+    {
+        if (holeCount == 0) {
+            return std::max(from, limit);
+        }
+
+        size_t word = from / 64;
+        if (word >= WORD_COUNT) {
+            return int(ChunkSize);
+        }
+
+        uint64_t bits = ~used[word] & ~lowBitsMask(from % 64);
+        while (bits == 0) {
+            if (++word == WORD_COUNT) {
+                return int(ChunkSize);
+            }
+
+            bits = ~used[word];
+        }
+
+        return std::min(int(word * 64) + countTrailingZeros(bits), int(ChunkSize));
+    }
+};
+
+// Сколько байт, не больше, занимает HolderSlots пачки из count элементов.
+constexpr size_t holderSlotsSize(size_t count)
+{
+    return (count + 63) / 64 * sizeof(uint64_t) + sizeof(void*) * 2 + sizeof(uint64_t);
+}
+
+// Как chunkSizeFor(), но у holder с удалением автоматическая пачка вместе
+// с HolderSlots укладывается в AUTO_CHUNK_BYTES, чтобы шаг пачек
+// не удваивался.
+template<class T, size_t Align = alignof(T)>
+constexpr size_t holderChunkSizeFor(size_t chunkSize, bool removable)
+{
+    return chunkSize != AUTO_CHUNK_SIZE ? chunkSize :
+        !removable ? autoChunkSize<T, Align>() : autoChunkSize<
+            T, Align, AUTO_CHUNK_BYTES - holderSlotsSize(autoChunkSize<T, Align>())
+        >();
+}
+
+constexpr size_t ceilPowerOf2(size_t value, size_t result = 1)
+{
+    return result >= value ? result : ceilPowerOf2(value, result * 2);
+}
+
+//##############################################################################
+//
+// HolderIter
+//  Пачку без дыр обходит подряд, как ChunkedIter, в пачке с дырами идёт
+//  по битам HolderSlots: биты текущего слова хранятся в итераторе, так
+//  что шаг внутри слова - один поиск младшего бита. Конец обхода
+//  определяется по кол-ву оставшихся элементов.
+//
+//##############################################################################
+
+template<class T, size_t ChunkSize, size_t Align, bool Const = false>
+class HolderIter
+{
+    using ChunkType = Chunk<T, ChunkSize, Align>;
+    using Slots = HolderSlots<ChunkType, ChunkSize>;
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = typename std::conditional<Const, const T*, T*>::type;
+    using reference = typename std::conditional<Const, const T&, T&>::type;
+
+    // index - занятый слот chunk, count - сколько элементов осталось
+    // обойти вместе с ним.
+    HolderIter(ChunkType* chunk = nullptr, int index = 0, int count = 0)
+    {
+        _chunk = chunk;
+        _index = index;
+        _count = count;
+        _dense = chunk == nullptr || Slots::of(chunk)->holeCount == 0;
+        _bits = _dense ? 0 : Slots::of(chunk)->usedAfter(index);
+    }
+
+    template<bool OtherConst, class = typename std::enable_if<Const && !OtherConst>::type>
+    HolderIter(const HolderIter<T, ChunkSize, Align, OtherConst>& other)
+    {
+        _chunk = other._chunk;
+        _index = other._index;
+        _count = other._count;
+        _bits = other._bits;
+        _dense = other._dense;
+    }
+
+    friend bool operator == (HolderIter const& a, HolderIter const& b)
+    {
+        return a._count == b._count;
+    }
+
+    friend bool operator != (HolderIter const& a, HolderIter const& b)
+    {
+        return a._count != b._count;
+    }
+
+    HolderIter& operator++() {
+        if (--_count == 0) {
+            return *this;
+        }
+
+        if (_dense) {
+            if (++_index == int(ChunkSize)) {
+                enterChunk(_chunk->next);
+            }
+            return *this;
+        }
+
+        if (_bits != 0) {
+            _index = (_index & ~63) + countTrailingZeros(_bits);
+            _bits &= _bits - 1;
+            return *this;
+        }
+
+        nextWord();
+        return *this;
+    }
+
+    HolderIter operator++(int) {
+        auto result = *this;
+        ++*this;
+        return result;
+    }
+
+    reference operator*() const
+    {
+        return _chunk->getValue(_index);
+    }
+
+    pointer operator->() const
+    {
+        return &**this;
+    }
+
+private:
+    ChunkType* _chunk;
+    int _index;
+    int _count;
+    // занятые слоты текущего слова после _index
+    uint64_t _bits;
+    // в текущей пачке нет дыр
+    bool _dense;
+
+    template<typename, size_t, size_t, bool>
+    friend class HolderIter;
+
+    void nextWord()
+    {
+        int index = Slots::of(_chunk)->findUsed((_index | 63) + 1, int(ChunkSize));
+        if (index < 0) {
+            enterChunk(_chunk->next);
+            return;
+        }
+
+        _index = index;
+        _bits = Slots::of(_chunk)->usedAfter(index);
+    }
+
+    // Первый элемент chunk. В цепочке holder нет пачек без элементов,
+    // а конец заполненной части не нужен: обход ограничен _count.
+    void enterChunk(ChunkType* chunk)
+    {
+        auto slots = Slots::of(chunk);
+        _chunk = chunk;
+        _dense = slots->holeCount == 0;
+        _index = slots->findUsed(0, int(ChunkSize));
+        _bits = _dense ? 0 : slots->usedAfter(_index);
+    }
+};
+
+//##############################################################################
+//
+// HolderEnumerator
+//  Перечислитель поверх итератора holder: с дырами пропускает их так же,
+//  как HolderIter.
+//
+//##############################################################################
+
+// Как и ChunkedEnumerator, current() даёт указатель на элемент, а у
+// holder указателей - сам указатель.
+template<class T>
+T* toItemPtr(T& value)
+{
+    return &value;
+}
+
+template<class T>
+T* toItemPtr(T*& value)
+{
+    return value;
+}
+
+template<class TIter>
+class HolderEnumerator
+{
+    using TPtr = typename std::remove_pointer<typename TIter::value_type>::type*;
+public:
+    HolderEnumerator(TIter first)
+    {
+        _current = first;
+        _next = first;
+    }
+
+    TPtr current()
+    {
+        return toItemPtr(*_current);
+    }
+
+    bool moveNext()
+    {
+        if (_next == TIter()) {
+            return false;
+        }
+
+        _current = _next;
+        ++_next;
+        return true;
+    }
+private:
+    TIter _current;
+    TIter _next;
+};
+
+//##############################################################################
+//
+// HolderView
+//  ChunkedView для holder с дырами: в оглавлении у пачки хранится ещё
+//  номер её первого элемента. Пока дыр нет, operator[] считает пачку
+//  делением, как ChunkedView, иначе ищет её двоичным поиском по оглавлению,
+//  а элемент в пачке - по кол-ву битов в словах HolderSlots. Оглавление
+//  больше INLINE_CHUNKS пачек берётся из кучи. Действительно, пока
+//  в holder не добавляли и не удаляли элементы.
+//
+//##############################################################################
+
+template<class T, size_t ChunkSize, size_t Align>
+class HolderView
+{
+    using TChunk = Chunk<T, ChunkSize, Align>;
+    using TSlots = HolderSlots<TChunk, ChunkSize>;
+    using TPtr = typename std::remove_pointer<T>::type*;
+public:
+    using Iter = HolderIter<T, ChunkSize, Align>;
+
+    // tailSize - кол-во заполненных слотов последней пачки.
+    HolderView(TChunk* head, int count, int tailSize)
+    {
+        _count = count;
+        _chunkCount = 0;
+        _dense = true;
+        _directory = _inline;
+
+        for (auto chunk = head; chunk; chunk = chunk->next) {
+            _chunkCount++;
+        }
+
+        if (_chunkCount > INLINE_CHUNKS) {
+            _directory = new Entry[_chunkCount];
+        }
+
+        int first = 0;
+        auto chunk = head;
+        for (int i = 0; i < _chunkCount; i++) {
+            auto holes = int(TSlots::of(chunk)->holeCount);
+            _directory[i].chunk = chunk;
+            _directory[i].first = first;
+            _dense = _dense && holes == 0;
+
+            first += (chunk->next ? int(ChunkSize) : tailSize) - holes;
+            chunk = chunk->next;
+        }
+    }
+
+    HolderView(HolderView&& src)
+    {
+        _count = src._count;
+        _chunkCount = src._chunkCount;
+        _dense = src._dense;
+        _directory = src._directory;
+
+        if (src._directory == src._inline) {
+            std::copy(src._inline, src._inline + _chunkCount, _inline);
+            _directory = _inline;
+        }
+
+        src._directory = src._inline;
+        src._count = 0;
+        src._chunkCount = 0;
+    }
+
+    ~HolderView()
+    {
+        if (_directory != _inline) {
+            delete[] _directory;
+        }
+    }
+
+    int count() const
+    {
+        return _count;
+    }
+
+    bool isEmpty() const
+    {
+        return _count == 0;
+    }
+
+    int chunkCount() const
+    {
+        return _chunkCount;
+    }
+
+    TPtr operator[] (int index) const
+    {
+        ASSERT(index >= 0 && index < _count, Errors::IndexOutOfRange);
+
+        if (_dense) {
+            return _directory[index / int(ChunkSize)].chunk->getItem(index % int(ChunkSize));
+        }
+
+        auto entry = std::upper_bound(
+            _directory, _directory + _chunkCount, index,
+            [](int value, const Entry& e) { return value < e.first; }
+        ) - 1;
+
+        return entry->chunk->getItem(findNth(entry->chunk, index - entry->first));
+    }
+
+    Iter begin() const
+    {
+        if (_count == 0) {
+            return Iter();
+        }
+
+        auto head = _directory[0].chunk;
+        return Iter(head, TSlots::of(head)->findUsed(0, int(ChunkSize)), _count);
+    }
+
+    Iter end() const
+    {
+        return Iter();
+    }
+
+    // func(first, n) для каждого отрезка подряд лежащих элементов, как
+    // forEachChunk() holder.
+    template<class Func>
+    void forEachChunk(Func func) const
+    {
+        static_assert(
+            TChunk::isContiguous(),
+            "Spans require Align not greater than alignof(T)"
+        );
+
+        for (int i = 0; i < _chunkCount; i++) {
+            auto chunk = _directory[i].chunk;
+            auto slots = TSlots::of(chunk);
+            int live = (i + 1 < _chunkCount ? _directory[i + 1].first : _count) - _directory[i].first;
+            if (slots->holeCount == 0) {
+                func(chunk->getData(), size_t(live));
+                continue;
+            }
+
+            int index = slots->findUsed(0, int(ChunkSize));
+            while (index >= 0) {
+                int end = slots->findFree(index, int(ChunkSize));
+                func(chunk->getData() + index, size_t(end - index));
+                index = slots->findUsed(end, int(ChunkSize));
+            }
+        }
+    }
+private:
+    struct Entry
+    {
+        TChunk* chunk;
+        // номер первого элемента пачки в представлении
+        int first;
+    };
+
+    static const int INLINE_CHUNKS = 8;
+
+    Entry* _directory;
+    Entry _inline[INLINE_CHUNKS];
+    int _count;
+    int _chunkCount;
+    // нет дыр
+    bool _dense;
+
+    HolderView(const HolderView&) = delete;
+
+    // Слот n-го по порядку элемента пачки.
+    static int findNth(TChunk* chunk, int n)
+    {
+        auto slots = TSlots::of(chunk);
+        if (slots->holeCount == 0) {
+            return n;
+        }
+
+        int word = 0;
+        for (int bits = countBits(slots->used[0]); n >= bits; bits = countBits(slots->used[++word])) {
+            n -= bits;
+        }
+
+        uint64_t bits = slots->used[word];
+        for (; n > 0; n--) {
+            bits &= bits - 1;
+        }
+
+        return word * 64 + countTrailingZeros(bits);
+    }
+};
+
+//##############################################################################
+//
+// ChunkedHolder
+//  С Removable remove() оставляет на месте элемента дыру: адреса остальных
+//  элементов не меняются, а add() занимает дыры раньше, чем конец. Пачка
+//  находится по адресу элемента за O(1): пачки лежат по адресам, кратным
+//  их шагу. Опустевшая пачка сразу возвращается пулу. compact() переносит
+//  элементы с конца в дыры. Без Removable дыр не бывает, пачки лежат
+//  плотно, а обход идёт через ChunkedIter.
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize>
-class ChunkedHolder : public ChunkedContainer<T, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize, size_t Align = alignof(T), bool Removable = false>
+class ChunkedHolder : public ChunkedContainer<T, Alloc, ChunkSize, Align>
 {
-    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize, Align>;
     using TPtr = typename Parent::TPtr;
     using TChunk = typename Parent::TChunk;
-    using TArray = typename Parent::TArray;
+    using TSlots = HolderSlots<TChunk, ChunkSize>;
+    using IsRemovable = std::integral_constant<bool, Removable>;
 public:
-    using Enumerator = typename Parent::TEnum;
+    using Iter = typename std::conditional<Removable,
+        HolderIter<T, ChunkSize, Align>, typename Parent::TIter>::type;
+    using ConstIter = typename std::conditional<Removable,
+        HolderIter<T, ChunkSize, Align, true>, typename Parent::TConstIter>::type;
+    using Enumerator = HolderEnumerator<Iter>;
+    using View = typename std::conditional<Removable,
+        HolderView<T, ChunkSize, Align>, typename Parent::TView>::type;
 
     ChunkedHolder(Alloc& alloc, size_t capacity)
         : Parent(alloc, capacity)
     {
+        _holed = nullptr;
+        _holeCount = 0;
+
+        if (Removable) {
+            this->_pool.setChunkStride(getChunkStride());
+        }
+    }
+
+    ChunkedHolder(ChunkedHolder&& src)
+        : Parent(std::move(src))
+    {
+        _holed = src._holed;
+        _holeCount = src._holeCount;
+
+        src._holed = nullptr;
+        src._holeCount = 0;
+    }
+
+    ChunkedHolder& operator=(ChunkedHolder&& src)
+    {
+        ChunkedHolder tmp(std::move(src));
+        swap(tmp);
+        return *this;
     }
 
     ~ChunkedHolder()
     {
-        this->releaseAllObjects(0);
+        releaseItems();
+    }
+
+    int count() const
+    {
+        return this->_count - _holeCount;
+    }
+
+    bool isEmpty() const
+    {
+        return count() == 0;
     }
 
     void clear()
     {
-        this->clearAllItems(0);
+        releaseItems();
+
+        // пачки уходят в пул без дыр
+        while (_holed) {
+            auto slots = TSlots::of(_holed);
+            _holed = slots->nextHoled;
+            slots->reset();
+        }
+
+        this->releaseChunks();
+        _holeCount = 0;
+    }
+
+    // Обмен содержимым за O(1).
+    void swap(ChunkedHolder& other)
+    {
+        this->swapItems(other);
+        std::swap(_holed, other._holed);
+        std::swap(_holeCount, other._holeCount);
+    }
+
+    // Переносит элементы src в конец без копирования: пачки src
+    // перецепляются, если count() кратен размеру пачки, ни в одном holder
+    // нет дыр и у них тот же аллокатор, иначе элементы перемещаются по
+    // одному. src остаётся пустым.
+    void stealChunks(ChunkedHolder& src)
+    {
+        if (&src == this || src.isEmpty()) {
+            return;
+        }
+
+        if (_holeCount == 0 && src._holeCount == 0 &&
+            this->_count % ChunkSize == 0 &&
+            this->_pool.allocator() == src._pool.allocator()) {
+            this->stealItems(src);
+            return;
+        }
+
+        src.forEachSlot([&](TChunk* chunk, int index) {
+            addItem(std::move(Parent::itemValue(chunk, index)));
+        });
+
+        src.clear();
+    }
+
+    // Добавляет копии [first, last), из массива тривиально копируемых
+    // элементов - memcpy по пачке за раз. Сначала занимаются дыры.
+    template<class InputIt>
+    void appendRange(InputIt first, InputIt last)
+    {
+        for (; _holed != nullptr && first != last; ++first) {
+            addItem(*first);
+        }
+
+        this->appendItems(0, first, last);
+    }
+
+    // Копирует элементы по порядку в out, возвращает out за последним.
+    template<class OutputIt>
+    OutputIt copyTo(OutputIt out) const
+    {
+        if (_holeCount == 0) {
+            return this->copyItems(0, out);
+        }
+
+        forEachSlot([&](TChunk* chunk, int index) {
+            *out = Parent::itemValue(chunk, index);
+            ++out;
+        });
+
+        return out;
+    }
+
+    // Переносит элементы с конца в дыры, если занято меньше minOccupancy
+    // (от 0 до 1) слотов; по умолчанию - при любой дыре. Адреса
+    // перенесённых элементов меняются, остальных - нет. Возвращает
+    // кол-во перенесённых элементов.
+    size_t compact(double minOccupancy = 1.0)
+    {
+        int live = count();
+        if (_holeCount == 0 || live >= minOccupancy * this->_count) {
+            return 0;
+        }
+
+        // дыр среди первых live слотов столько же, сколько элементов
+        // после них
+        size_t moved = 0;
+        TChunk* dst = this->_head;
+        int dstIndex = -1;
+        TChunk* src = chunkAt(live / ChunkSize);
+        int srcIndex = int(live % ChunkSize) - 1;
+        while (findSlot(src, srcIndex, true)) {
+            findSlot(dst, dstIndex, false);
+            dst->setItem(dstIndex, std::move(Parent::itemValue(src, srcIndex)));
+            this->releaseItem(src, srcIndex);
+            TSlots::of(dst)->setUsed(dstIndex);
+            TSlots::of(src)->setFree(srcIndex);
+            moved++;
+        }
+
+        for (auto chunk = this->_head; chunk; chunk = chunk->next) {
+            TSlots::of(chunk)->reset();
+        }
+
+        auto tail = chunkAt((live - 1) / ChunkSize);
+        if (tail->next) {
+            this->_pool.release(tail->next, true);
+            tail->next = nullptr;
+        }
+
+        this->_tail = tail;
+        this->_count = live;
+        _holed = nullptr;
+        _holeCount = 0;
+        return moved;
     }
 
     Enumerator getEnumerator()
     {
-        return this->getEnum(0);
+        return Enumerator(begin());
+    }
+
+    // Представление элементов без копирования, O(кол-ва пачек), см.
+    // ChunkedView и HolderView.
+    View toArray()
+    {
+        return makeView(IsRemovable());
+    }
+
+    Iter begin()
+    {
+        return getBegin<Iter>();
+    }
+
+    Iter end()
+    {
+        return Iter();
     }
 
-    TArray toArray()
+    ConstIter begin() const
     {
-        return this->getArray(0);
+        return getBegin<ConstIter>();
+    }
+
+    ConstIter end() const
+    {
+        return ConstIter();
+    }
+
+    // func(first, n) для каждого отрезка подряд лежащих элементов: без
+    // дыр - по одному на пачку, см. forEachSpan().
+    template<class Func>
+    void forEachChunk(Func func)
+    {
+        if (_holeCount == 0) {
+            this->forEachSpan(0, func);
+            return;
+        }
+
+        for (auto chunk = this->_head; chunk; chunk = chunk->next) {
+            auto slots = TSlots::of(chunk);
+            int size = slotCount(chunk);
+            int index = slots->findUsed(0, size);
+            while (index >= 0) {
+                int end = slots->findFree(index, size);
+                func(Parent::itemSlot(chunk, index), size_t(end - index));
+                index = slots->findUsed(end, size);
+            }
+        }
+    }
+
+    // Делит элементы на части из целых пачек, не меньше grainSize
+    // элементов (кроме последней), и вызывает func(first, count) для
+    // каждой по порядку. Деление зависит только от grainSize. Части
+    // независимы, их обходит parallelForEach() из Parallel.h.
+    template<class Func>
+    void forEachPart(size_t grainSize, Func func)
+    {
+        auto chunk = this->_head;
+        int left = count();
+        while (left > 0) {
+            Iter first(chunk, firstUsed(chunk), left);
+            size_t size = 0;
+            while (left > 0 && size < grainSize) {
+                int chunkCount = liveCount(chunk);
+                size += chunkCount;
+                left -= chunkCount;
+                chunk = chunk->next;
+            }
+
+            func(first, size);
+        }
+    }
+protected:
+    // Добавляет элемент в первую пачку с дырами или в конец, возвращает
+    // адрес его слота.
+    template<typename ...Args>
+    T* addItem(Args&&... args)
+    {
+        if (_holed == nullptr) {
+            this->appendItem(std::forward<Args>(args)...);
+            return Parent::itemSlot(this->_tail, int((this->_count - 1) % ChunkSize));
+        }
+
+        auto chunk = _holed;
+        auto slots = TSlots::of(chunk);
+        int index = slots->findFree(0, slotCount(chunk));
+        chunk->setItem(index, std::forward<Args>(args)...);
+        slots->setUsed(index);
+
+        _holeCount--;
+        if (--slots->holeCount == 0) {
+            unlinkHoled(chunk);
+        }
+
+        return Parent::itemSlot(chunk, index);
+    }
+
+    // Разрушает элемент по адресу слота, который вернул addItem().
+    void removeItem(T* item)
+    {
+        static_assert(Removable, "remove() requires Removable holder");
+
+        CHECK_NULL_ARG(item);
+
+        auto chunk = reinterpret_cast<TChunk*>(
+            reinterpret_cast<uintptr_t>(item) & ~uintptr_t(getChunkStride() - 1)
+        );
+        int index = Parent::itemIndex(chunk, item);
+        int size = slotCount(chunk);
+        auto slots = TSlots::of(chunk);
+        if (index < 0 || index >= size || (slots->holeCount != 0 && !slots->isUsed(index))) {
+            RAISE(ArgumentException, Errors::UnknownItem);
+        }
+
+        this->releaseItem(chunk, index);
+
+        // первая дыра: с этого момента биты пачки ведутся
+        if (slots->holeCount == 0) {
+            slots->reset();
+            slots->setUsed(0, size);
+            linkHoled(chunk);
+        }
+
+        slots->setFree(index);
+        slots->holeCount++;
+        _holeCount++;
+
+        if (liveCount(chunk) == 0) {
+            releaseEmpty(chunk);
+        }
+    }
+private:
+    // пачки с дырами
+    TChunk* _holed;
+    // удалённые элементы всех пачек
+    int _holeCount;
+
+    static constexpr size_t getChunkStride()
+    {
+        return ceilPowerOf2(sizeof(TChunk) + sizeof(TSlots));
+    }
+
+    template<class It>
+    It getBegin() const
+    {
+        if (count() == 0) {
+            return It();
+        }
+
+        return It(this->_head, firstUsed(this->_head), count());
+    }
+
+    View makeView(std::false_type)
+    {
+        return this->getView(0);
+    }
+
+    View makeView(std::true_type)
+    {
+        if (count() == 0) {
+            return View(nullptr, 0, 0);
+        }
+
+        return View(this->_head, count(), slotCount(this->_tail));
+    }
+
+    // HolderSlots есть только у пачек holder с Removable.
+    static bool hasHoles(TChunk* chunk)
+    {
+        return Removable && TSlots::of(chunk)->holeCount != 0;
+    }
+
+    static int firstUsed(TChunk* chunk)
+    {
+        return hasHoles(chunk) ? TSlots::of(chunk)->findUsed(0, int(ChunkSize)) : 0;
+    }
+
+    // Сколько слотов пачки заполнено или было заполнено.
+    int slotCount(TChunk* chunk) const
+    {
+        return chunk == this->_tail ? int((this->_count - 1) % ChunkSize) + 1 : int(ChunkSize);
+    }
+
+    int liveCount(TChunk* chunk) const
+    {
+        return slotCount(chunk) - (hasHoles(chunk) ? int(TSlots::of(chunk)->holeCount) : 0);
+    }
+
+    TChunk* chunkAt(int number) const
+    {
+        auto chunk = this->_head;
+        for (int i = 0; i < number; i++) {
+            chunk = chunk->next;
+        }
+
+        return chunk;
+    }
+
+    // Следующий после index занятый (used) или свободный слот, начиная
+    // с пачки chunk. false, если такого нет до конца цепочки.
+    bool findSlot(TChunk*& chunk, int& index, bool used) const
+    {
+        while (chunk) {
+            auto slots = TSlots::of(chunk);
+            int size = slotCount(chunk);
+            index = used ? slots->findUsed(index + 1, size) : slots->findFree(index + 1, size);
+            if (index >= 0 && index < size) {
+                return true;
+            }
+
+            chunk = chunk->next;
+            index = -1;
+        }
+
+        return false;
+    }
+
+    // func(chunk, index) для каждого занятого слота по порядку.
+    template<class Func>
+    void forEachSlot(Func func) const
+    {
+        if (this->_count == 0) {
+            return;
+        }
+
+        for (auto chunk = this->_head; chunk; chunk = chunk->next) {
+            int size = slotCount(chunk);
+            if (!hasHoles(chunk)) {
+                for (int i = 0; i < size; i++) {
+                    func(chunk, i);
+                }
+                continue;
+            }
+
+            auto slots = TSlots::of(chunk);
+            for (int i = slots->findUsed(0, size); i >= 0; i = slots->findUsed(i + 1, size)) {
+                func(chunk, i);
+            }
+        }
+    }
+
+    void releaseItems()
+    {
+        if (_holeCount == 0) {
+            this->releaseAllObjects(0);
+        } else if (!std::is_trivially_destructible<T>::value) {
+            forEachSlot([&](TChunk* chunk, int index) {
+                this->releaseItem(chunk, index);
+            });
+        }
+    }
+
+    void linkHoled(TChunk* chunk)
+    {
+        auto slots = TSlots::of(chunk);
+        slots->prevHoled = nullptr;
+        slots->nextHoled = _holed;
+        if (_holed) {
+            TSlots::of(_holed)->prevHoled = chunk;
+        }
+
+        _holed = chunk;
+    }
+
+    void unlinkHoled(TChunk* chunk)
+    {
+        auto slots = TSlots::of(chunk);
+        if (slots->prevHoled) {
+            TSlots::of(slots->prevHoled)->nextHoled = slots->nextHoled;
+        } else {
+            _holed = slots->nextHoled;
+        }
+
+        if (slots->nextHoled) {
+            TSlots::of(slots->nextHoled)->prevHoled = slots->prevHoled;
+        }
+
+        slots->nextHoled = nullptr;
+        slots->prevHoled = nullptr;
+    }
+
+    // Возвращает пулу пачку без элементов. Позиции слотов в последней
+    // пачке не меняются: перед ней остаются только полные пачки.
+    void releaseEmpty(TChunk* chunk)
+    {
+        auto slots = TSlots::of(chunk);
+        unlinkHoled(chunk);
+        _holeCount -= int(slots->holeCount);
+        slots->holeCount = 0;
+
+        if (chunk == this->_head && chunk == this->_tail) {
+            this->_count = 0;
+            return;
+        }
+
+        if (chunk == this->_tail) {
+            this->_count -= slotCount(chunk);
+            this->_tail = chunk->prev;
+            this->_tail->next = nullptr;
+        } else {
+            this->_count -= int(ChunkSize);
+            if (chunk == this->_head) {
+                this->_head = chunk->next;
+                this->_head->prev = nullptr;
+            } else {
+                chunk->prev->next = chunk->next;
+                chunk->next->prev = chunk->prev;
+            }
+        }
+
+        this->_pool.release(chunk, false);
     }
 };
 
@@ -53,13 +1034,23 @@ public:
 //##############################################################################
 //
 // ObjHolder
+//  Removable включает remove(). За него платят памятью: шаг пачки вместе
+//  с битами занятости округляется до степени двойки, и при явном
+//  ChunckSize на выравнивание может уходить почти половина пачки.
+//  Автоматический размер пачки подбирается так, чтобы шаг не рос.
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunckSize = Internal::DEF_CHUNK_SIZE>
-class ObjHolder final : public Internal::ChunkedHolder<T, Alloc, ChunckSize>
+template<class T, class Alloc, size_t ChunckSize = Internal::AUTO_CHUNK_SIZE,
+         size_t Align = alignof(T), bool Removable = false>
+class ObjHolder final
+    : public Internal::ChunkedHolder<
+        T, Alloc, Internal::holderChunkSizeFor<T, Align>(ChunckSize, Removable), Align, Removable
+    >
 {
-    using Parent = Internal::ChunkedHolder<T, Alloc, ChunckSize>;
+    using Parent = Internal::ChunkedHolder<
+        T, Alloc, Internal::holderChunkSizeFor<T, Align>(ChunckSize, Removable), Align, Removable
+    >;
 
     static_assert(
         std::is_class<T>::value,
@@ -71,20 +1062,33 @@ public:
     template<typename ...Args>
     T* add(Args&&... args)
     {
-        return this->appendItem(std::forward<Args>(args)...);
+        return this->addItem(std::forward<Args>(args)...);
+    }
+
+    // O(1), адреса остальных элементов не меняются. Только с Removable.
+    void remove(T* item)
+    {
+        this->removeItem(item);
     }
 };
 
 //##############################################################################
 //
 // PtrHolder
+//  Removable - как у ObjHolder.
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunckSize = Internal::DEF_CHUNK_SIZE>
-class PtrHolder final : public Internal::ChunkedHolder<T*, Alloc, ChunckSize>
+template<class T, class Alloc, size_t ChunckSize = Internal::AUTO_CHUNK_SIZE,
+         bool Removable = false>
+class PtrHolder final
+    : public Internal::ChunkedHolder<
+        T*, Alloc, Internal::holderChunkSizeFor<T*>(ChunckSize, Removable), alignof(T*), Removable
+    >
 {
-    using Parent = Internal::ChunkedHolder<T*, Alloc, ChunckSize>;
+    using Parent = Internal::ChunkedHolder<
+        T*, Alloc, Internal::holderChunkSizeFor<T*>(ChunckSize, Removable), alignof(T*), Removable
+    >;
 
     static_assert(
         std::is_class<T>::value,
@@ -93,9 +1097,16 @@ class PtrHolder final : public Internal::ChunkedHolder<T*, Alloc, ChunckSize>
 public:
     using Parent::Parent;
 
-    void add(T* value)
+    // Возвращает слот значения, по нему работает remove().
+    T** add(T* value)
+    {
+        return this->addItem(value);
+    }
+
+    // Только с Removable.
+    void remove(T** slot)
     {
-        this->appendItem(value);
+        this->removeItem(slot);
     }
 };
 
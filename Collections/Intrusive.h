@@ -0,0 +1,519 @@
+﻿#ifndef INTRUSIVE_H
+#define INTRUSIVE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+
+#include "Consts.h"
+#include "../Debug.h"
+#include "../Exception.h"
+
+namespace GreedyContainers {
+
+//##############################################################################
+//
+// SlHook, DlHook
+//  Связи, встроенные в сам объект. Интрузивный список не выделяет память
+//  и не владеет объектами: объект должен жить, пока он в списке.
+//  Списки кольцевые, поэтому у связанного узла next никогда не равен
+//  nullptr. Связи не копируются: копия объекта из списка в нём не состоит,
+//  а присваивание оставляет объект там, где он был.
+//
+//##############################################################################
+
+struct SlHook
+{
+    SlHook* next = nullptr;
+
+    SlHook() = default;
+
+    SlHook(const SlHook&)
+    {
+    }
+
+    SlHook& operator = (const SlHook&)
+    {
+        return *this;
+    }
+
+    bool isLinked() const
+    {
+        return next != nullptr;
+    }
+};
+
+struct DlHook
+{
+    DlHook* next = nullptr;
+    DlHook* prev = nullptr;
+
+    DlHook() = default;
+
+    DlHook(const DlHook&)
+    {
+    }
+
+    DlHook& operator = (const DlHook&)
+    {
+        return *this;
+    }
+
+    bool isLinked() const
+    {
+        return next != nullptr;
+    }
+
+    // Исключает объект из списка, в котором он находится, за O(1).
+    void unlink()
+    {
+        ASSERT(isLinked());
+
+        next->prev = prev;
+        prev->next = next;
+        next = nullptr;
+        prev = nullptr;
+    }
+};
+
+//##############################################################################
+//
+// BaseHook, MemberHook
+//  Как найти связи в объекте: T наследует HookType или содержит его
+//  как член Member. Смещение члена без объекта не вычислить, поэтому
+//  MemberHook запоминает его у первого объекта, прошедшего через toHook:
+//  до связей любого объекта список добирается только так.
+//
+//##############################################################################
+
+template<class T, class HookType>
+struct BaseHook
+{
+    using Hook = HookType;
+
+    static Hook* toHook(T* value)
+    {
+        return static_cast<Hook*>(value);
+    }
+
+    static T* toValue(Hook* hook)
+    {
+        return static_cast<T*>(hook);
+    }
+};
+
+template<class T, class HookType, HookType T::*Member>
+struct MemberHook
+{
+    using Hook = HookType;
+
+    static Hook* toHook(T* value)
+    {
+        auto hook = &(value->*Member);
+        if (_offset.load(std::memory_order_relaxed) == UNKNOWN_OFFSET) {
+            _offset.store(
+                reinterpret_cast<uintptr_t>(hook) - reinterpret_cast<uintptr_t>(value),
+                std::memory_order_relaxed
+            );
+        }
+
+        return hook;
+    }
+
+    static T* toValue(Hook* hook)
+    {
+        auto offset = _offset.load(std::memory_order_relaxed);
+        return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(hook) - offset);
+    }
+private:
+    static const size_t UNKNOWN_OFFSET = ~size_t(0);
+
+    // у всех объектов T одинаково, поэтому гонка записей безвредна
+    static std::atomic<size_t> _offset;
+};
+
+template<class T, class HookType, HookType T::*Member>
+std::atomic<size_t> MemberHook<T, HookType, Member>::_offset(UNKNOWN_OFFSET);
+
+namespace Internal {
+
+//##############################################################################
+//
+// IntrusiveIter
+//
+//##############################################################################
+
+template<class T, class HookPolicy>
+class IntrusiveIter
+{
+    using HookType = typename HookPolicy::Hook;
+public:
+    IntrusiveIter(HookType* hook)
+    {
+        _hook = hook;
+    }
+
+    bool operator != (IntrusiveIter const& other) const
+    {
+        return _hook != other._hook;
+    }
+
+    IntrusiveIter& operator++() {
+        _hook = _hook->next;
+        return *this;
+    }
+
+    T& operator*() const
+    {
+        return *HookPolicy::toValue(_hook);
+    }
+
+private:
+    HookType* _hook;
+};
+
+}
+
+//##############################################################################
+//
+// IntrusiveSlList
+//  Кол-во элементов не хранится: count() - O(n), remove() - O(n).
+//
+//##############################################################################
+
+template<class T, class HookPolicy = BaseHook<T, SlHook>>
+class IntrusiveSlList
+{
+    static_assert(
+        std::is_same<typename HookPolicy::Hook, SlHook>::value,
+        "IntrusiveSlList requires SlHook"
+    );
+public:
+    using Iter = Internal::IntrusiveIter<T, HookPolicy>;
+
+    IntrusiveSlList()
+    {
+        initData();
+    }
+
+    IntrusiveSlList(IntrusiveSlList&& src)
+    {
+        initData();
+        if (!src.isEmpty()) {
+            _head.next = src._head.next;
+            _last = src._last;
+            _last->next = &_head;
+            src.initData();
+        }
+    }
+
+    ~IntrusiveSlList()
+    {
+        clear();
+    }
+
+    bool isEmpty() const
+    {
+        return _head.next == &_head;
+    }
+
+    size_t count() const
+    {
+        size_t result = 0;
+        for (auto hook = _head.next; hook != &_head; hook = hook->next) {
+            result++;
+        }
+
+        return result;
+    }
+
+    T* first()
+    {
+        checkNotEmpty();
+        return HookPolicy::toValue(_head.next);
+    }
+
+    void addFirst(T* value)
+    {
+        linkAfter(&_head, value);
+    }
+
+    void addLast(T* value)
+    {
+        linkAfter(_last, value);
+    }
+
+    void insertAfter(T* prev, T* value)
+    {
+        CHECK_NULL_ARG(prev);
+
+        auto prevHook = HookPolicy::toHook(prev);
+        ASSERT(prevHook->isLinked());
+        linkAfter(prevHook, value);
+    }
+
+    T* removeFirst()
+    {
+        checkNotEmpty();
+        auto hook = _head.next;
+        unlinkAfter(&_head);
+        return HookPolicy::toValue(hook);
+    }
+
+    void remove(T* value)
+    {
+        CHECK_NULL_ARG(value);
+
+        auto hook = HookPolicy::toHook(value);
+        for (auto prev = &_head; prev->next != &_head; prev = prev->next) {
+            if (prev->next == hook) {
+                unlinkAfter(prev);
+                return;
+            }
+        }
+
+        RAISE(ArgumentException, Internal::Errors::UnknownNode);
+    }
+
+    void clear()
+    {
+        auto hook = _head.next;
+        while (hook != &_head) {
+            auto next = hook->next;
+            hook->next = nullptr;
+            hook = next;
+        }
+
+        initData();
+    }
+
+    Iter begin()
+    {
+        return _head.next;
+    }
+
+    Iter end()
+    {
+        return &_head;
+    }
+private:
+    SlHook _head;
+    SlHook* _last;
+
+    IntrusiveSlList(const IntrusiveSlList&) = delete;
+
+    void initData()
+    {
+        _head.next = &_head;
+        _last = &_head;
+    }
+
+    void checkNotEmpty() const
+    {
+        if (isEmpty()) {
+            RAISE(RuntimeException, Internal::Errors::EmptyContainer);
+        }
+    }
+
+    void linkAfter(SlHook* prev, T* value)
+    {
+        CHECK_NULL_ARG(value);
+
+        auto hook = HookPolicy::toHook(value);
+        ASSERT(!hook->isLinked());
+
+        hook->next = prev->next;
+        prev->next = hook;
+        if (prev == _last) {
+            _last = hook;
+        }
+    }
+
+    void unlinkAfter(SlHook* prev)
+    {
+        auto hook = prev->next;
+        prev->next = hook->next;
+        if (hook == _last) {
+            _last = prev;
+        }
+
+        hook->next = nullptr;
+    }
+};
+
+//##############################################################################
+//
+// IntrusiveDlList
+//  Кол-во элементов не хранится, чтобы объект мог исключить себя сам
+//  через DlHook::unlink(): count() - O(n), remove() - O(1).
+//
+//##############################################################################
+
+template<class T, class HookPolicy = BaseHook<T, DlHook>>
+class IntrusiveDlList
+{
+    static_assert(
+        std::is_same<typename HookPolicy::Hook, DlHook>::value,
+        "IntrusiveDlList requires DlHook"
+    );
+public:
+    using Iter = Internal::IntrusiveIter<T, HookPolicy>;
+
+    IntrusiveDlList()
+    {
+        initData();
+    }
+
+    IntrusiveDlList(IntrusiveDlList&& src)
+    {
+        initData();
+        if (!src.isEmpty()) {
+            _head.next = src._head.next;
+            _head.prev = src._head.prev;
+            _head.next->prev = &_head;
+            _head.prev->next = &_head;
+            src.initData();
+        }
+    }
+
+    ~IntrusiveDlList()
+    {
+        clear();
+    }
+
+    bool isEmpty() const
+    {
+        return _head.next == &_head;
+    }
+
+    size_t count() const
+    {
+        size_t result = 0;
+        for (auto hook = _head.next; hook != &_head; hook = hook->next) {
+            result++;
+        }
+
+        return result;
+    }
+
+    T* first()
+    {
+        checkNotEmpty();
+        return HookPolicy::toValue(_head.next);
+    }
+
+    T* last()
+    {
+        checkNotEmpty();
+        return HookPolicy::toValue(_head.prev);
+    }
+
+    void addFirst(T* value)
+    {
+        linkBefore(_head.next, value);
+    }
+
+    void addLast(T* value)
+    {
+        linkBefore(&_head, value);
+    }
+
+    void insertBefore(T* next, T* value)
+    {
+        CHECK_NULL_ARG(next);
+
+        auto nextHook = HookPolicy::toHook(next);
+        ASSERT(nextHook->isLinked());
+        linkBefore(nextHook, value);
+    }
+
+    void insertAfter(T* prev, T* value)
+    {
+        CHECK_NULL_ARG(prev);
+
+        auto prevHook = HookPolicy::toHook(prev);
+        ASSERT(prevHook->isLinked());
+        linkBefore(prevHook->next, value);
+    }
+
+    T* removeFirst()
+    {
+        checkNotEmpty();
+        auto hook = _head.next;
+        hook->unlink();
+        return HookPolicy::toValue(hook);
+    }
+
+    T* removeLast()
+    {
+        checkNotEmpty();
+        auto hook = _head.prev;
+        hook->unlink();
+        return HookPolicy::toValue(hook);
+    }
+
+    // Принадлежность объекта списку не проверяется.
+    void remove(T* value)
+    {
+        CHECK_NULL_ARG(value);
+        HookPolicy::toHook(value)->unlink();
+    }
+
+    void clear()
+    {
+        auto hook = _head.next;
+        while (hook != &_head) {
+            auto next = hook->next;
+            hook->next = nullptr;
+            hook->prev = nullptr;
+            hook = next;
+        }
+
+        initData();
+    }
+
+    Iter begin()
+    {
+        return _head.next;
+    }
+
+    Iter end()
+    {
+        return &_head;
+    }
+private:
+    DlHook _head;
+
+    IntrusiveDlList(const IntrusiveDlList&) = delete;
+
+    void initData()
+    {
+        _head.next = &_head;
+        _head.prev = &_head;
+    }
+
+    void checkNotEmpty() const
+    {
+        if (isEmpty()) {
+            RAISE(RuntimeException, Internal::Errors::EmptyContainer);
+        }
+    }
+
+    void linkBefore(DlHook* next, T* value)
+    {
+        CHECK_NULL_ARG(value);
+
+        auto hook = HookPolicy::toHook(value);
+        ASSERT(!hook->isLinked());
+
+        hook->next = next;
+        hook->prev = next->prev;
+        next->prev->next = hook;
+        next->prev = hook;
+    }
+};
+
+}
+
+#endif // INTRUSIVE_H
@@ -2,14 +2,18 @@
 #define BASE_H
 
 #include <utility>
+#include <stddef.h>
 #include <stdint.h>
+#include <iterator>
 #include <algorithm>
 #include <type_traits>
 
 #include "Consts.h"
 #include "../Align.h"
 #include "../Debug.h"
+#include "../Memory.h"
 #include "../Exception.h"
+#include "AllocTraits.h"
 
 namespace GreedyContainers {
 namespace Internal {
@@ -20,37 +24,78 @@ namespace Internal {
 //
 //##############################################################################
 
-template<class T>
+// Объект лежит сразу за узлом, его адрес вычисляется, а не хранится.
+// Узел и объект выровнены на Align, но не меньше, чем требует сам T.
+template<class T, size_t Align = alignof(T)>
 struct SlNode
 {
-    T* value;
     SlNode* next;
+#ifdef DEBUG
+    // next у освобождённого узла занят свободным списком пула, поэтому
+    // признак хранится отдельно и только в Debug
+    bool released;
+#endif
 
     template<typename ...Args>
     void init(Args&&... args)
     {
-        auto value = new (getDataPtr()) T(std::forward<Args>(args)...);
-        this->value = value;
+        new (getDataPtr()) T(std::forward<Args>(args)...);
+#ifdef DEBUG
+        released = false;
+#endif
     }
 
     void release()
     {
-        this->value->~T();
-        this->value = nullptr;
+#ifdef DEBUG
+        ASSERT(!released, Errors::ReleasedNode);
+#endif
+        getValue()->~T();
+#ifdef DEBUG
+        released = true;
+#endif
+    }
+
+    T* getValue()
+    {
+        return reinterpret_cast<T*>(getDataPtr());
+    }
+
+    T& getRef()
+    {
+        return *getValue();
+    }
+
+    // В Release освобождённый узел не отличить от занятого.
+    bool isEmpty() const
+    {
+#ifdef DEBUG
+        return released;
+#else
+        return false;
+#endif
+    }
+
+    static constexpr size_t getAlign() {
+        return maxAlign(maxAlign(Align, alignof(T)), alignof(SlNode));
     }
 
     static constexpr size_t getDataSize() {
-        return alignToDefault(sizeof(T)) + alignToDefault(sizeof(SlNode));
+        return alignValue(getDataOffset() + sizeof(T), getAlign());
     }
 private:
+    static constexpr size_t getDataOffset() {
+        return alignValue(sizeof(SlNode), maxAlign(Align, alignof(T)));
+    }
+
     void* getDataPtr()
     {
-        return Memory::ptrInc(this, alignToDefault(sizeof(SlNode)));
+        return Memory::ptrInc(this, getDataOffset());
     }
 };
 
-template<class T>
-struct SlNode<T*>
+template<class T, size_t Align>
+struct SlNode<T*, Align>
 {
     T* value;
     SlNode* next;
@@ -65,6 +110,25 @@ struct SlNode<T*>
         this->value = nullptr;
     }
 
+    T* getValue()
+    {
+        return value;
+    }
+
+    T*& getRef()
+    {
+        return value;
+    }
+
+    bool isEmpty() const
+    {
+        return value == nullptr;
+    }
+
+    static constexpr size_t getAlign() {
+        return alignof(SlNode);
+    }
+
     static constexpr size_t getDataSize() {
         return alignToDefault(sizeof(SlNode));
     }
@@ -73,37 +137,76 @@ struct SlNode<T*>
 //##############################################################################
 //
 // SlIter
+//  Прямой итератор STL. Разыменование даёт ссылку на значение:
+//  for (auto& value : list) value.... У списка указателей значение -
+//  сам указатель. С Const ссылка константная. С Prefetch при переходе
+//  к узлу сразу запрашивается в кэш следующий, пока обрабатывается
+//  текущий.
 //
 //##############################################################################
 
-template<class T>
+template<class T, size_t Align = alignof(T), bool Const = false, bool Prefetch = false>
 class SlIter
 {
-    using NodeType = SlNode<T>;
+    using NodeType = SlNode<T, Align>;
 public:
-    SlIter(NodeType* node)
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = typename std::conditional<Const, const T*, T*>::type;
+    using reference = typename std::conditional<Const, const T&, T&>::type;
+
+    SlIter(NodeType* node = nullptr)
     {
         _node = node;
     }
 
-    bool operator != (SlIter const& other) const
+    // неконстантный итератор приводится к константному
+    template<bool OtherConst, class = typename std::enable_if<Const && !OtherConst>::type>
+    SlIter(const SlIter<T, Align, OtherConst, Prefetch>& other)
+    {
+        _node = other._node;
+    }
+
+    friend bool operator == (SlIter const& a, SlIter const& b)
+    {
+        return a._node == b._node;
+    }
+
+    friend bool operator != (SlIter const& a, SlIter const& b)
     {
-        return _node != other._node;
+        return a._node != b._node;
     }
 
     SlIter& operator++() {
         _node = _node->next;
+        if (Prefetch && _node) {
+            Memory::prefetch(_node->next);
+        }
         return *this;
     }
 
-    typename std::remove_pointer<T>::type*
-    operator*() const
+    SlIter operator++(int) {
+        auto result = *this;
+        ++*this;
+        return result;
+    }
+
+    reference operator*() const
+    {
+        return _node->getRef();
+    }
+
+    pointer operator->() const
     {
-        return _node->value;
+        return &_node->getRef();
     }
 
 private:
     NodeType* _node;
+
+    template<class, size_t, bool, bool>
+    friend class SlIter;
 };
 
 //##############################################################################
@@ -112,38 +215,63 @@ private:
 //
 //##############################################################################
 
-template<class T>
+// Объект лежит сразу за узлом, его адрес вычисляется, а не хранится.
+// Узел и объект выровнены на Align, но не меньше, чем требует сам T.
+template<class T, size_t Align = alignof(T)>
 struct DlNode
 {
-    T* value;
     DlNode* next;
     DlNode* prev;
 
     template<typename ...Args>
     void init(Args&&... args)
     {
-        auto value = new (getDataPtr()) T(std::forward<Args>(args)...);
-        this->value = value;
+        new (getDataPtr()) T(std::forward<Args>(args)...);
     }
 
+    // prev пулом не используется и служит признаком освобождённого узла:
+    // у узла в списке он всегда указывает хотя бы на голову.
     void release()
     {
-        this->value->~T();
-        this->value = nullptr;
+        getValue()->~T();
+        this->prev = nullptr;
+    }
+
+    T* getValue()
+    {
+        return reinterpret_cast<T*>(getDataPtr());
+    }
+
+    T& getRef()
+    {
+        return *getValue();
+    }
+
+    bool isEmpty() const
+    {
+        return prev == nullptr;
+    }
+
+    static constexpr size_t getAlign() {
+        return maxAlign(maxAlign(Align, alignof(T)), alignof(DlNode));
     }
 
     static constexpr size_t getDataSize() {
-        return alignToDefault(sizeof(T)) + alignToDefault(sizeof(DlNode));
+        return alignValue(getDataOffset() + sizeof(T), getAlign());
     }
 private:
+    static constexpr size_t getDataOffset() {
+        return alignValue(sizeof(DlNode), maxAlign(Align, alignof(T)));
+    }
+
     void* getDataPtr()
     {
-        return Memory::ptrInc(this, alignToDefault(sizeof(DlNode)));
+        return Memory::ptrInc(this, getDataOffset());
     }
 };
 
-template<class T>
-struct DlNode<T*>
+template<class T, size_t Align>
+struct DlNode<T*, Align>
 {
     T* value;
     DlNode* next;
@@ -159,6 +287,25 @@ struct DlNode<T*>
         this->value = nullptr;
     }
 
+    T* getValue()
+    {
+        return value;
+    }
+
+    T*& getRef()
+    {
+        return value;
+    }
+
+    bool isEmpty() const
+    {
+        return value == nullptr;
+    }
+
+    static constexpr size_t getAlign() {
+        return alignof(DlNode);
+    }
+
     static constexpr size_t getDataSize() {
         return alignToDefault(sizeof(DlNode));
     }
@@ -166,38 +313,113 @@ struct DlNode<T*>
 
 //##############################################################################
 //
-// DlIter...
+// DlIter
+//  Двунаправленный итератор STL, в остальном как SlIter. Обратный обход -
+//  std::reverse_iterator над ним (rbegin(), rend() у списка).
 //
 //##############################################################################
 
-template<class T>
-class DlIterForward
+template<class T, size_t Align = alignof(T), bool Const = false, bool Prefetch = false>
+class DlIter
 {
-    using NodeType = DlNode<T>;
+    using NodeType = DlNode<T, Align>;
 public:
-    DlIterForward(NodeType* node)
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = typename std::conditional<Const, const T*, T*>::type;
+    using reference = typename std::conditional<Const, const T&, T&>::type;
+
+    DlIter(NodeType* node = nullptr)
     {
         _node = node;
     }
 
-    bool operator != (DlIterForward const& other) const
+    // неконстантный итератор приводится к константному
+    template<bool OtherConst, class = typename std::enable_if<Const && !OtherConst>::type>
+    DlIter(const DlIter<T, Align, OtherConst, Prefetch>& other)
     {
-        return _node != other._node;
+        _node = other._node;
     }
 
-    DlIterForward& operator++() {
+    friend bool operator == (DlIter const& a, DlIter const& b)
+    {
+        return a._node == b._node;
+    }
+
+    friend bool operator != (DlIter const& a, DlIter const& b)
+    {
+        return a._node != b._node;
+    }
+
+    // у головы prev и у хвоста next равны nullptr, запрос по ним безвреден
+    DlIter& operator++() {
         _node = _node->next;
+        if (Prefetch) {
+            Memory::prefetch(_node->next);
+        }
         return *this;
     }
 
-    typename std::remove_pointer<T>::type*
-    operator*() const
+    DlIter operator++(int) {
+        auto result = *this;
+        ++*this;
+        return result;
+    }
+
+    DlIter& operator--() {
+        _node = _node->prev;
+        if (Prefetch) {
+            Memory::prefetch(_node->prev);
+        }
+        return *this;
+    }
+
+    DlIter operator--(int) {
+        auto result = *this;
+        --*this;
+        return result;
+    }
+
+    reference operator*() const
+    {
+        return _node->getRef();
+    }
+
+    pointer operator->() const
     {
-        return _node->value;
+        return &_node->getRef();
     }
 
 private:
     NodeType* _node;
+
+    template<class, size_t, bool, bool>
+    friend class DlIter;
+};
+
+//##############################################################################
+//
+// IterRange
+//  Пара итераторов для for по диапазону, например list.prefetched().
+//
+//##############################################################################
+
+template<class Iter>
+struct IterRange
+{
+    Iter first;
+    Iter last;
+
+    Iter begin() const
+    {
+        return first;
+    }
+
+    Iter end() const
+    {
+        return last;
+    }
 };
 
 //##############################################################################
@@ -224,8 +446,8 @@ public:
     operator ->() const
     {
         CHECK_NULL_PTR(_node);
-        CHECK_NULL_PTR(_node->value);
-        return _node->value;
+        ASSERT(!_node->isEmpty());
+        return _node->getValue();
     }
 
 private:
@@ -238,7 +460,7 @@ protected:
     Item(NodeType* node)
     {
         ASSERT(node != nullptr);
-        ASSERT(node->value != nullptr);
+        ASSERT(!node->isEmpty());
 
         _node = node;
     }
@@ -272,12 +494,212 @@ public:
     }
 };
 
+//##############################################################################
+//
+// DetachedNode
+//  Узел, созданный в пуле списка, но не связанный со списком. Позволяет
+//  создать или уничтожить элемент вне блокировки, под которой живёт
+//  список. Если узел так и не добавлен в список, он возвращается в пул.
+//
+//##############################################################################
+
+template<class T, class NodeType, class Pool>
+class DetachedHelper;
+
+template<class T, class NodeType, class Pool>
+class DetachedNode
+{
+public:
+    DetachedNode(DetachedNode&& src)
+    {
+        CHECK_NULL_ARG(src._node);
+        _node = src._node;
+        _pool = src._pool;
+        src._node = nullptr;
+    }
+
+    ~DetachedNode()
+    {
+        if (_node) {
+            _pool->release(_node);
+        }
+    }
+
+    typename std::remove_pointer<T>::type*
+    operator ->() const
+    {
+        CHECK_NULL_PTR(_node);
+        return _node->getValue();
+    }
+
+private:
+    DetachedNode() = delete;
+    DetachedNode(DetachedNode& src) = delete;
+    DetachedNode(const DetachedNode& src) = delete;
+
+    NodeType* _node;
+    Pool* _pool;
+
+    DetachedNode(NodeType* node, Pool* pool)
+    {
+        ASSERT(node != nullptr);
+
+        _node = node;
+        _pool = pool;
+    }
+
+    friend class DetachedHelper<T, NodeType, Pool>;
+};
+
+template<class T, class NodeType, class Pool>
+class DetachedHelper
+{
+    using DetachedType = DetachedNode<T, NodeType, Pool>;
+public:
+    static DetachedType make(NodeType* node, Pool* pool)
+    {
+        return DetachedType(node, pool);
+    }
+
+    static NodeType* take(DetachedType& detached)
+    {
+        CHECK_NULL_ARG(detached._node);
+
+        auto node = detached._node;
+        detached._node = nullptr;
+        return node;
+    }
+};
+
+//##############################################################################
+//
+// sortChain
+//  Сортировка односвязной цепочки по полю next. Восходящая сортировка
+//  слиянием: O(n log n), без выделения памяти, устойчивая.
+//
+//##############################################################################
+
+// Сливает упорядоченные цепочки, при равенстве первым идёт элемент first.
+template<class Link, class Less>
+Link* mergeChains(Link* first, Link* second, Less& less)
+{
+    Link* head = nullptr;
+    Link** tail = &head;
+    while (first && second) {
+        if (less(second, first)) {
+            *tail = second;
+            second = second->next;
+        } else {
+            *tail = first;
+            first = first->next;
+        }
+        tail = &(*tail)->next;
+    }
+
+    *tail = first ? first : second;
+    return head;
+}
+
+template<class Link, class Less>
+Link* sortChain(Link* head, Less less)
+{
+    // В bins[i] - отсортированная цепочка из 2^i элементов. Сливаются
+    // цепочки одной длины, пока недавно пройденные узлы ещё в кэше;
+    // в более старших ячейках лежат более ранние элементы.
+    const size_t BIN_COUNT = sizeof(size_t) * 8;
+    Link* bins[BIN_COUNT] = {};
+
+    while (head) {
+        auto run = head;
+        head = head->next;
+        run->next = nullptr;
+
+        size_t i = 0;
+        for (; i < BIN_COUNT - 1 && bins[i]; i++) {
+            run = mergeChains(bins[i], run, less);
+            bins[i] = nullptr;
+        }
+
+        bins[i] = i == BIN_COUNT - 1 && bins[i] ? mergeChains(bins[i], run, less) : run;
+    }
+
+    Link* result = nullptr;
+    for (size_t i = 0; i < BIN_COUNT; i++) {
+        if (bins[i]) {
+            result = mergeChains(bins[i], result, less);
+        }
+    }
+
+    return result;
+}
+
 //##############################################################################
 //
 // NodePool
 //
 //##############################################################################
 
+struct NodeChunk
+{
+    NodeChunk* next;
+    // кол-во узлов в пачке
+    size_t size;
+
+    // align - выравнивание узлов, пачка выделяется с ним же
+    void* begin(size_t align)
+    {
+        return Memory::ptrInc(this, getHeaderSize(align));
+    }
+
+    void* end(size_t nodeSize, size_t align)
+    {
+        return Memory::ptrInc(begin(align), size * nodeSize);
+    }
+
+    static constexpr size_t getHeaderSize(size_t align) {
+        return alignValue(sizeof(NodeChunk), maxAlign(align, DEFAULT_ALIGN));
+    }
+};
+
+// Сколько узлов помещается в AUTO_CHUNK_BYTES вместе с заголовком пачки.
+template<class NodeType>
+constexpr size_t autoNodeChunkSize()
+{
+    return (AUTO_CHUNK_BYTES - NodeChunk::getHeaderSize(NodeType::getAlign())) /
+           NodeType::getDataSize();
+}
+
+// Явно заданный размер пачки узлов или AUTO_CHUNK_SIZE, как chunkSizeFor()
+// у chunked-контейнеров. Автоматическая пачка не меньше MIN_CHUNK_SIZE.
+template<class NodeType>
+constexpr size_t nodeChunkSizeFor(size_t chunkSize)
+{
+    return chunkSize != AUTO_CHUNK_SIZE ? chunkSize :
+        autoNodeChunkSize<NodeType>() > MIN_CHUNK_SIZE ?
+            autoNodeChunkSize<NodeType>() : MIN_CHUNK_SIZE;
+}
+
+struct NodePoolStats
+{
+    // всего узлов во всех пачках
+    size_t nodeCount;
+    // занятых узлов
+    size_t liveCount;
+    size_t chunkCount;
+    // пачек, в которых нет ни одного занятого узла
+    size_t emptyChunkCount;
+    // свободных узлов в частично занятых пачках, включая ещё не нарезанный
+    // хвост текущей пачки
+    size_t scatteredCount;
+
+    // Доля узлов, которые свободны, но не могут быть возвращены аллокатору,
+    // потому что их пачка частично занята.
+    double fragmentation() const
+    {
+        return nodeCount == 0 ? 0.0 : double(scatteredCount) / nodeCount;
+    }
+};
+
 template<class NodeType, class Allocator>
 class NodePool
 {
@@ -285,40 +707,94 @@ public:
     NodePool(Allocator& allocator, size_t chunkSize, size_t capacity)
     {
         _top = nullptr;
+        _chunks = nullptr;
+        _current = nullptr;
+        _cursor = nullptr;
+        _cursorEnd = nullptr;
         _allocator = &allocator;
+        _nodeCount = 0;
+        _freeCount = 0;
+        _autoTrim = false;
 
         _chunkSize = chunkSize;
         _chunkSize = std::max(_chunkSize, MIN_CHUNK_SIZE);
         _chunkSize = std::min(_chunkSize, MAX_CHUNK_SIZE);
-
-        allocChunk(capacity);
+        // первая пачка берётся при первом create(), поэтому пустой пул
+        // не занимает памяти
+        _growSize = capacity ? capacity : _chunkSize;
+        _trimThreshold = _chunkSize * TRIM_MIN_CHUNKS;
     }
 
     NodePool(NodePool&& src)
     {
-        ASSERT(src._top != nullptr);
         ASSERT(src._allocator != nullptr);
         ASSERT(src._chunkSize >= MIN_CHUNK_SIZE);
         ASSERT(src._chunkSize <= MAX_CHUNK_SIZE);
 
         _top = src._top;
+        _chunks = src._chunks;
+        _current = src._current;
+        _cursor = src._cursor;
+        _cursorEnd = src._cursorEnd;
         _allocator = src._allocator;
         _chunkSize = src._chunkSize;
+        _growSize = src._growSize;
+        _nodeCount = src._nodeCount;
+        _freeCount = src._freeCount;
+        _autoTrim = src._autoTrim;
+        _trimThreshold = src._trimThreshold;
 
         src._top = nullptr;
+        src._chunks = nullptr;
+        src._current = nullptr;
+        src._cursor = nullptr;
+        src._cursorEnd = nullptr;
+        src._nodeCount = 0;
+        src._freeCount = 0;
+    }
+
+    ~NodePool()
+    {
+        if (!HasFree<Allocator>::value) {
+            return;
+        }
+
+        auto chunk = _chunks;
+        while (chunk) {
+            auto next = chunk->next;
+            freeMemory(*_allocator, chunk);
+            chunk = next;
+        }
     }
 
     template<typename ...Args>
     NodeType* create(Args&&... args)
     {
-        allocChunk(_chunkSize);
+        // Сначала берём освобождённые узлы, они ещё в кэше. Новые узлы
+        // нарезаются из текущей пачки по мере надобности, поэтому её
+        // страницы не трогаются заранее.
+        auto result = _top;
+        if (result == nullptr) {
+            if (_cursor == _cursorEnd) {
+                allocChunk(_growSize);
+                _growSize = std::max(_growSize * 2, _chunkSize);
+                _growSize = std::min(_growSize, MAX_CHUNK_SIZE);
+            }
+
+            result = reinterpret_cast<NodeType*>(_cursor);
+        }
 
         // In order not to damage internal states when exception raised, it
         // is necessary to call the client's constructor first.
-        _top->init(std::forward<Args>(args)...);
+        result->init(std::forward<Args>(args)...);
 
-        auto result = _top;
-        _top = _top->next;
+        if (result == _top) {
+            _top = _top->next;
+        } else {
+            _cursor = Memory::ptrInc(_cursor, NodeType::getDataSize());
+        }
+
+        _freeCount--;
         return result;
     }
 
@@ -329,35 +805,229 @@ public:
         node->release();
         node->next = _top;
         _top = node;
+        _freeCount++;
+
+        if (_autoTrim && _freeCount > _trimThreshold && _freeCount > _nodeCount - _freeCount) {
+            shrink();
+        }
+    }
+
+    // Возвращает аллокатору пачки, в которых не осталось занятых узлов.
+    // Для аллокаторов без free() ничего не делает. Возвращает кол-во
+    // освобождённых пачек.
+    size_t shrink()
+    {
+        if (!HasFree<Allocator>::value || _freeCount == 0) {
+            return 0;
+        }
+
+        size_t released = 0;
+        NodeChunk* kept = nullptr;
+        NodeChunk** keptTail = &kept;
+        NodeType* freeList = nullptr;
+        NodeType** freeTail = &freeList;
+
+        forEachChunk([&](NodeChunk* chunk, NodeType* first,
+                         NodeType* last, size_t freeNodes) {
+            if (freeNodes == chunk->size) {
+                _nodeCount -= freeNodes;
+                _freeCount -= freeNodes;
+                released++;
+                if (chunk == _current) {
+                    _current = nullptr;
+                    _cursor = nullptr;
+                    _cursorEnd = nullptr;
+                }
+
+                freeMemory(*_allocator, chunk);
+                return;
+            }
+
+            *keptTail = chunk;
+            keptTail = &chunk->next;
+            if (last) {
+                *freeTail = first;
+                freeTail = &last->next;
+            }
+        });
+
+        *keptTail = nullptr;
+        *freeTail = nullptr;
+        _chunks = kept;
+        _top = freeList;
+
+        if (released) {
+            _growSize = _chunkSize;
+        }
+
+        // Если вернуть почти ничего не удалось, следующая автоматическая
+        // чистка будет не раньше, чем свободных узлов станет вдвое больше.
+        _trimThreshold = std::max(_chunkSize * TRIM_MIN_CHUNKS, _freeCount * 2);
+        return released;
+    }
+
+    // Включает автоматический shrink(), когда свободных узлов становится
+    // больше, чем занятых.
+    void setAutoTrim(bool enabled)
+    {
+        _autoTrim = enabled && HasFree<Allocator>::value;
+    }
+
+    // Упорядочивает свободный список по адресу, O(n log n).
+    NodePoolStats getStats()
+    {
+        NodePoolStats stats = {};
+        stats.nodeCount = _nodeCount;
+        stats.liveCount = _nodeCount - _freeCount;
+
+        forEachChunk([&](NodeChunk* chunk, NodeType*, NodeType*, size_t freeNodes) {
+            stats.chunkCount++;
+            if (freeNodes == chunk->size) {
+                stats.emptyChunkCount++;
+            } else {
+                stats.scatteredCount += freeNodes;
+            }
+        });
+
+        return stats;
     }
 private:
+    // после shrink() автоматическая чистка не запускается, пока свободных
+    // узлов меньше, чем на столько пачек
+    static const size_t TRIM_MIN_CHUNKS = 4;
+
+    // начальный размер пачки
     size_t _chunkSize;
+    // размер следующей пачки: сначала capacity, затем растёт вдвое
+    // до MAX_CHUNK_SIZE
+    size_t _growSize;
+    // освобождённые узлы
     NodeType* _top;
+    NodeChunk* _chunks;
+    // пачка, из которой нарезаются новые узлы, и её ненарезанный остаток
+    NodeChunk* _current;
+    void* _cursor;
+    void* _cursorEnd;
     Allocator* _allocator;
+    size_t _nodeCount;
+    size_t _freeCount;
+    size_t _trimThreshold;
+    bool _autoTrim;
 
+    // Остаток прежней текущей пачки теряется до shrink(), поэтому новая
+    // пачка берётся, только когда он исчерпан.
     void allocChunk(size_t size)
     {
-        if (_top || size == 0) {
-            return;
-        }
-
-        _top = reinterpret_cast<NodeType*>(
-            _allocator->alloc(size * NodeType::getDataSize())
-        );
+        ASSERT(_cursor == _cursorEnd);
+
+        auto align = NodeType::getAlign();
+        auto chunk = reinterpret_cast<NodeChunk*>(_allocator->alloc(
+            NodeChunk::getHeaderSize(align) + size * NodeType::getDataSize(), align
+        ));
+        CHECK_NULL_PTR(chunk);
+
+        chunk->size = size;
+        chunk->next = _chunks;
+        _chunks = chunk;
+        _nodeCount += size;
+        _freeCount += size;
+
+        _current = chunk;
+        _cursor = chunk->begin(align);
+        _cursorEnd = chunk->end(NodeType::getDataSize(), align);
+    }
 
-        auto entry = _top;
-        for (int i = 0; i < size - 1; i++) {
-            entry->next = reinterpret_cast<NodeType*>(
-                Memory::ptrInc(entry, NodeType::getDataSize())
+    // Сортирует пачки и свободный список по адресу и для каждой пачки
+    // вызывает func(chunk, first, last, freeNodes), где first..last -
+    // отрезок свободного списка, лежащий в этой пачке (last == nullptr,
+    // если его нет), а freeNodes учитывает и ненарезанный хвост. После
+    // вызова связи next пачек и узлов могут быть изменены func.
+    template<class Func>
+    void forEachChunk(Func func)
+    {
+        auto byAddress = [](const void* a, const void* b) {
+            return reinterpret_cast<uintptr_t>(a) < reinterpret_cast<uintptr_t>(b);
+        };
+
+        _chunks = sortChain(_chunks, byAddress);
+        _top = sortChain(_top, byAddress);
+
+        auto node = _top;
+        auto chunk = _chunks;
+        while (chunk) {
+            auto nextChunk = chunk->next;
+            auto end = reinterpret_cast<uintptr_t>(
+                chunk->end(NodeType::getDataSize(), NodeType::getAlign())
             );
 
-            entry = entry->next;
+            auto first = node;
+            NodeType* last = nullptr;
+            size_t freeNodes = 0;
+            while (node && reinterpret_cast<uintptr_t>(node) < end) {
+                last = node;
+                node = node->next;
+                freeNodes++;
+            }
+
+            if (chunk == _current) {
+                auto uncarved = reinterpret_cast<uintptr_t>(_cursorEnd)
+                              - reinterpret_cast<uintptr_t>(_cursor);
+                freeNodes += uncarved / NodeType::getDataSize();
+            }
+
+            func(chunk, first, last, freeNodes);
+            chunk = nextChunk;
         }
+    }
+};
+
+//##############################################################################
+//
+// SharedNodePool
+//  Ссылка на NodePool, общий для нескольких списков. Между такими
+//  списками узлы можно перецеплять, не пересоздавая объекты. Пул должен
+//  пережить списки.
+//
+//##############################################################################
+
+template<class NodeType, class Allocator>
+class SharedNodePool
+{
+public:
+    using Target = NodePool<NodeType, Allocator>;
+
+    SharedNodePool(Target& target)
+    {
+        _target = &target;
+    }
 
-        entry->next = nullptr;
+    template<typename ...Args>
+    NodeType* create(Args&&... args)
+    {
+        return _target->create(std::forward<Args>(args)...);
+    }
+
+    void release(NodeType* node)
+    {
+        _target->release(node);
+    }
 
-        CHECK_NULL_PTR(_top);
+    size_t shrink()
+    {
+        return _target->shrink();
+    }
+
+    void setAutoTrim(bool enabled)
+    {
+        _target->setAutoTrim(enabled);
     }
+
+    bool isSame(const SharedNodePool& other) const
+    {
+        return _target == other._target;
+    }
+private:
+    Target* _target;
 };
 
 }
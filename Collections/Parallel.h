@@ -0,0 +1,95 @@
+﻿#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <stddef.h>
+
+#include "../ThreadPool.h"
+
+namespace GreedyContainers {
+
+// элементов в одной части по умолчанию
+const size_t DEF_GRAIN_SIZE = 16384;
+
+//##############################################################################
+//
+// parallelForEach, parallelReduce
+//  Обход ObjHolder/PtrHolder на потоках ThreadPool. Цепочка пачек
+//  делится на части из целых пачек не меньше grainSize элементов, каждая
+//  часть - одно задание пула. Во время обхода holder менять нельзя.
+//
+//##############################################################################
+
+namespace Internal {
+
+template<class Holder>
+struct HolderPart
+{
+    typename Holder::Iter first;
+    size_t count;
+};
+
+template<class Holder>
+std::vector<HolderPart<Holder>> splitHolder(Holder& holder, size_t grainSize)
+{
+    std::vector<HolderPart<Holder>> parts;
+    holder.forEachPart(grainSize, [&](typename Holder::Iter first, size_t count) {
+        parts.push_back({first, count});
+    });
+
+    return parts;
+}
+
+}
+
+// Вызывает func(value) для каждого элемента, порядок вызовов не задан.
+template<class Holder, class Func>
+void parallelForEach(ThreadPool& pool, Holder& holder, Func func,
+                     size_t grainSize = DEF_GRAIN_SIZE)
+{
+    auto parts = Internal::splitHolder(holder, grainSize);
+    auto task = [&](size_t index) {
+        auto it = parts[index].first;
+        for (size_t i = 0; i < parts[index].count; i++, ++it) {
+            func(*it);
+        }
+    };
+
+    pool.run(parts.size(), task);
+}
+
+// Каждая часть сворачивается как acc = accumulate(acc, value), начиная с
+// identity, затем результаты частей объединяются combine(result, part)
+// по порядку частей. Деление на части не зависит от кол-ва потоков,
+// поэтому результат одинаков при любом их числе, в том числе для
+// чисел с плавающей точкой.
+template<class Holder, class R, class Accumulate, class Combine>
+R parallelReduce(ThreadPool& pool, Holder& holder, R identity,
+                 Accumulate accumulate, Combine combine,
+                 size_t grainSize = DEF_GRAIN_SIZE)
+{
+    auto parts = Internal::splitHolder(holder, grainSize);
+    std::vector<R> results(parts.size(), identity);
+    auto task = [&](size_t index) {
+        auto acc = identity;
+        auto it = parts[index].first;
+        for (size_t i = 0; i < parts[index].count; i++, ++it) {
+            acc = accumulate(acc, *it);
+        }
+
+        results[index] = acc;
+    };
+
+    pool.run(parts.size(), task);
+
+    auto result = identity;
+    for (auto& part : results) {
+        result = combine(result, part);
+    }
+
+    return result;
+}
+
+}
+
+#endif // PARALLEL_H
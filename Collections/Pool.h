@@ -6,7 +6,7 @@
 
 namespace GreedyContainers {
 
-template<class T, class Alloc, size_t ChunkSize>
+template<class T, class Alloc, size_t ChunkSize = Internal::AUTO_CHUNK_SIZE>
 class Pool
 {
     using TNode = Internal::SlNode<T*>;
@@ -30,7 +30,7 @@ public:
 
         T* operator ->() const
         {
-            return _node->value;
+            return _node->getValue();
         }
     private:
         Pool* _owner;
@@ -39,7 +39,7 @@ public:
 public:
     Pool(Alloc& alloc, size_t capacity)
         : _holder(alloc, 2),
-          _nodePool(alloc, ChunkSize, capacity)
+          _nodePool(alloc, Internal::nodeChunkSizeFor<TNode>(ChunkSize), capacity)
     {
         _tail = nullptr;
     }
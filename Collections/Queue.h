@@ -12,18 +12,36 @@ namespace Internal {
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize>
-class ChunkedQueue : public ChunkedContainer<T, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize, size_t Align = alignof(T)>
+class ChunkedQueue : public ChunkedContainer<T, Alloc, ChunkSize, Align>
 {
-    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize, Align>;
     using TPtr = typename Parent::TPtr;
 public:
+    using Iter = typename Parent::TIter;
+    using ConstIter = typename Parent::TConstIter;
+    using View = typename Parent::TView;
+
     ChunkedQueue(Alloc& alloc, size_t capacity)
         : Parent(alloc, capacity)
     {
         _headIndex = 0;
     }
 
+    ChunkedQueue(ChunkedQueue&& src)
+        : Parent(std::move(src))
+    {
+        _headIndex = src._headIndex;
+        src._headIndex = 0;
+    }
+
+    ChunkedQueue& operator=(ChunkedQueue&& src)
+    {
+        ChunkedQueue tmp(std::move(src));
+        swap(tmp);
+        return *this;
+    }
+
     ~ChunkedQueue()
     {
         this->releaseAllObjects(_headIndex);
@@ -38,9 +56,137 @@ public:
     void dequeue()
     {
         this->emptyCheck();
+        removeHead();
+    }
+
+    // Варианты без исключений для опроса пустой очереди. tryPeek()
+    // возвращает nullptr, если очередь пуста; у PtrQueue его не отличить
+    // от добавленного nullptr, для неё есть tryPopInto().
+    TPtr tryPeek()
+    {
+        return this->isEmpty() ? nullptr : this->_head->getItem(_headIndex);
+    }
+
+    bool tryDequeue()
+    {
+        if (this->isEmpty()) {
+            return false;
+        }
+
+        removeHead();
+        return true;
+    }
+
+    // Перемещает первый элемент в out и удаляет его.
+    bool tryPopInto(T& out)
+    {
+        if (this->isEmpty()) {
+            return false;
+        }
+
+        out = std::move(this->itemValue(this->_head, _headIndex));
+        removeHead();
+        return true;
+    }
+
+    // Добавляет count элементов из values, см. appendRange().
+    void enqueueN(const T* values, int count)
+    {
+        this->appendItems(_headIndex, values, values + count);
+    }
+
+    // Переносит до maxCount первых элементов в out - массив уже созданных
+    // объектов, возвращает их кол-во. Пачки, которые при этом опустели,
+    // возвращаются пулу разом.
+    int dequeueN(T* out, int maxCount)
+    {
+        int count = std::min(maxCount, this->_count);
+        dequeueItems(count, out);
+        return count;
+    }
+
+    void clear()
+    {
+        this->clearAllItems(_headIndex);
+    }
+
+    // Обмен содержимым за O(1).
+    void swap(ChunkedQueue& other)
+    {
+        this->swapItems(other);
+        std::swap(_headIndex, other._headIndex);
+    }
 
+    // Добавляет копии [first, last), из массива тривиально копируемых
+    // элементов - memcpy по пачке за раз.
+    template<class InputIt>
+    void appendRange(InputIt first, InputIt last)
+    {
+        this->appendItems(_headIndex, first, last);
+    }
+
+    // Копирует элементы по порядку в out, возвращает out за последним.
+    template<class OutputIt>
+    OutputIt copyTo(OutputIt out) const
+    {
+        return this->copyItems(_headIndex, out);
+    }
+
+    // Представление элементов без копирования, O(кол-ва пачек), см.
+    // ChunkedView.
+    View toArray()
+    {
+        return this->getView(_headIndex);
+    }
+
+    Iter begin()
+    {
+        return this->getBegin(_headIndex);
+    }
+
+    Iter end()
+    {
+        return this->getEnd();
+    }
+
+    ConstIter begin() const
+    {
+        return this->getBegin(_headIndex);
+    }
+
+    ConstIter end() const
+    {
+        return this->getEnd();
+    }
+
+    // func(first, n) для элементов каждой пачки, см. forEachSpan().
+    template<class Func>
+    void forEachChunk(Func func)
+    {
+        this->forEachSpan(_headIndex, func);
+    }
+protected:
+    template<class OutputIt>
+    OutputIt dequeueItems(int count, OutputIt out)
+    {
+        return this->takeFront(_headIndex, count, out);
+    }
+
+    // в отличие от appendItem(), пишет после первого элемента, а не с
+    // начала первой пачки
+    template<typename ...Args>
+    TPtr enqueueItem(Args&&... args)
+    {
+        return this->appendItemAt(_headIndex, std::forward<Args>(args)...);
+    }
+private:
+    int _headIndex;
+
+    void removeHead()
+    {
         this->releaseItem(this->_head, _headIndex);
-        this-> _count--;
+
+        this->_count--;
         _headIndex++;
 
         if (_headIndex == ChunkSize || this->_count == 0) {
@@ -53,13 +199,6 @@ public:
             }
         }
     }
-
-    void clear()
-    {
-        this->clearAllItems(_headIndex);
-    }
-private:
-    int _headIndex;
 };
 
 } // Internal end
@@ -70,10 +209,12 @@ private:
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize = Internal::DEF_CHUNK_SIZE>
-class ObjQueue final : public Internal::ChunkedQueue<T, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize = Internal::AUTO_CHUNK_SIZE,
+         size_t Align = alignof(T)>
+class ObjQueue final
+    : public Internal::ChunkedQueue<T, Alloc, Internal::chunkSizeFor<T, Align>(ChunkSize), Align>
 {
-    using Parent = Internal::ChunkedQueue<T, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedQueue<T, Alloc, Internal::chunkSizeFor<T, Align>(ChunkSize), Align>;
 
     static_assert(
         std::is_class<T>::value,
@@ -85,7 +226,7 @@ public:
     template<typename ...Args>
     T* enqueue(Args&&... args)
     {
-        return this->appendItem(std::forward<Args>(args)...);
+        return this->enqueueItem(std::forward<Args>(args)...);
     }
 };
 
@@ -95,10 +236,11 @@ public:
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize = Internal::DEF_CHUNK_SIZE>
-class PtrQueue final : public Internal::ChunkedQueue<T*, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize = Internal::AUTO_CHUNK_SIZE>
+class PtrQueue final
+    : public Internal::ChunkedQueue<T*, Alloc, Internal::chunkSizeFor<T*>(ChunkSize)>
 {
-    using Parent = Internal::ChunkedQueue<T*, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedQueue<T*, Alloc, Internal::chunkSizeFor<T*>(ChunkSize)>;
 
     static_assert(
         std::is_class<T>::value,
@@ -109,7 +251,17 @@ public:
 
     void enqueue(T* value)
     {
-        this->appendItem(value);
+        this->enqueueItem(value);
+    }
+
+    // Переносит в builder столько первых элементов, сколько в нём
+    // поместится, и возвращает их кол-во.
+    template<class BuilderAlloc>
+    int drainTo(ArrayBuilder<T, BuilderAlloc>& builder)
+    {
+        int count = std::min(this->count(), builder.limitCount() - builder.count());
+        this->dequeueItems(count, builder.inserter());
+        return count;
     }
 };
 
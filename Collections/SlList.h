@@ -18,15 +18,19 @@ namespace Internal {
 //
 //##############################################################################
 
-template<class T, class Allocator>
+template<class T, class Allocator, template<class, class> class Pool,
+         size_t Align = alignof(T)>
 class BaseSingleLinkedList
 {
 public:
-    using NodeType = SlNode<T>;
-    using NodeAllocatorType = NodePool<NodeType, Allocator>;
+    using NodeType = SlNode<T, Align>;
+    using NodeAllocatorType = Pool<NodeType, Allocator>;
+    using NodePoolType = NodePool<NodeType, Allocator>;
     using ItemHelperType = ItemHelper<T, NodeType>;
 public:
-    using IterType = SlIter<T>;
+    using IterType = SlIter<T, Align>;
+    using ConstIterType = SlIter<T, Align, true>;
+    using PrefetchIterType = SlIter<T, Align, false, true>;
     using ItemType = Item<T, NodeType>;
 
     ~BaseSingleLinkedList()
@@ -46,11 +50,42 @@ public:
         initData();
     }
 
-    size_t count()
+    size_t count() const
     {
         return _count;
     }
 
+    // Возвращает аллокатору пачки узлов, в которых не осталось элементов.
+    size_t shrink()
+    {
+        return _nodeAllocator.shrink();
+    }
+
+    void setAutoTrim(bool enabled)
+    {
+        _nodeAllocator.setAutoTrim(enabled);
+    }
+
+    // Сортирует список по less(a, b), который получает указатели на
+    // значения. Сортировка слиянием по связям узлов: устойчивая, без
+    // выделения памяти, O(n log n). Item остаются действительными.
+    template<class Less>
+    void sort(Less less)
+    {
+        if (_count < 2) {
+            return;
+        }
+
+        _head.next = sortChain(_head.next, [&](NodeType* a, NodeType* b) {
+            return less(a->getValue(), b->getValue());
+        });
+
+        _last = _head.next;
+        while (_last->next) {
+            _last = _last->next;
+        }
+    }
+
     IterType begin()
     {
         return _head.next;
@@ -60,6 +95,33 @@ public:
     {
         return nullptr;
     }
+
+    ConstIterType begin() const
+    {
+        return _head.next;
+    }
+
+    ConstIterType end() const
+    {
+        return nullptr;
+    }
+
+    ConstIterType cbegin() const
+    {
+        return begin();
+    }
+
+    ConstIterType cend() const
+    {
+        return end();
+    }
+
+    // Обход с упреждающей загрузкой следующего узла, для списков, чьи
+    // узлы разбросаны по памяти: for (auto& value : list.prefetched()).
+    IterRange<PrefetchIterType> prefetched()
+    {
+        return {_head.next, nullptr};
+    }
 protected:
     BaseSingleLinkedList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : _nodeAllocator(allocator, chunkSize, capacity)
@@ -67,12 +129,17 @@ protected:
         initData();
     }
 
+    explicit BaseSingleLinkedList(NodePoolType& pool)
+        : _nodeAllocator(pool)
+    {
+        initData();
+    }
+
     BaseSingleLinkedList(BaseSingleLinkedList&& src)
         : _nodeAllocator(std::move(src._nodeAllocator))
     {
         _last = src._last;
         _head.next = src._head.next;
-        _head.value = nullptr;
         _count = src._count;
 
         src.initData();
@@ -119,7 +186,6 @@ private:
     {
         _last = &_head;
         _head.next = nullptr;
-        _head.value = nullptr;
         _count = 0;
     }
 
@@ -186,10 +252,11 @@ private:
 //
 //##############################################################################
 
-template<class T, class Allocator>
-class SlObjList : public Internal::BaseSingleLinkedList<T, Allocator>
+template<class T, class Allocator, template<class, class> class Pool = Internal::NodePool,
+         size_t Align = alignof(T)>
+class SlObjList : public Internal::BaseSingleLinkedList<T, Allocator, Pool, Align>
 {
-    using Parent = Internal::BaseSingleLinkedList<T, Allocator>;
+    using Parent = Internal::BaseSingleLinkedList<T, Allocator, Pool, Align>;
 
     static_assert(
         std::is_class<T>::value,
@@ -198,11 +265,18 @@ class SlObjList : public Internal::BaseSingleLinkedList<T, Allocator>
 public:
     using Item = typename Parent::ItemType;
     using Iter = typename Parent::IterType;
+    using ConstIter = typename Parent::ConstIterType;
+    using NodePoolType = typename Parent::NodePoolType;
 
     SlObjList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : Parent(allocator, chunkSize, capacity)
     {}
 
+    // Только с Pool = SharedNodePool.
+    explicit SlObjList(NodePoolType& pool)
+        : Parent(pool)
+    {}
+
     template<typename ...Args>
     Item addFirst(Args&&... args)
     {
@@ -234,10 +308,10 @@ public:
 //
 //##############################################################################
 
-template<class T, class Allocator>
-class SlPtrList : public Internal::BaseSingleLinkedList<T*, Allocator>
+template<class T, class Allocator, template<class, class> class Pool = Internal::NodePool>
+class SlPtrList : public Internal::BaseSingleLinkedList<T*, Allocator, Pool>
 {
-    using Parent = Internal::BaseSingleLinkedList<T*, Allocator>;
+    using Parent = Internal::BaseSingleLinkedList<T*, Allocator, Pool>;
 
     static_assert(
         std::is_class<T>::value,
@@ -247,11 +321,18 @@ class SlPtrList : public Internal::BaseSingleLinkedList<T*, Allocator>
 public:
     using Item = typename Parent::ItemType;
     using Iter = typename Parent::IterType;
+    using ConstIter = typename Parent::ConstIterType;
+    using NodePoolType = typename Parent::NodePoolType;
 
     SlPtrList(Allocator& allocator, size_t chunkSize, size_t capacity)
         : Parent(allocator, chunkSize, capacity)
     {}
 
+    // Только с Pool = SharedNodePool.
+    explicit SlPtrList(NodePoolType& pool)
+        : Parent(pool)
+    {}
+
     Item addFirst(T* value)
     {
         return this->doAddFirst(value);
@@ -12,21 +12,35 @@ namespace Internal {
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize>
-class ChunkedStack : public ChunkedContainer<T, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize, size_t Align = alignof(T)>
+class ChunkedStack : public ChunkedContainer<T, Alloc, ChunkSize, Align>
 {
-    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedContainer<T, Alloc, ChunkSize, Align>;
     using TPtr = typename Parent::TPtr;
     using TChunk = typename Parent::TChunk;
-    using TArray = typename Parent::TArray;
 public:
     using Enumerator = typename Parent::TEnum;
+    using Iter = typename Parent::TIter;
+    using ConstIter = typename Parent::TConstIter;
+    using View = typename Parent::TView;
 
     ChunkedStack(Alloc& alloc, size_t capacity)
         : Parent(alloc, capacity)
     {
     }
 
+    ChunkedStack(ChunkedStack&& src)
+        : Parent(std::move(src))
+    {
+    }
+
+    ChunkedStack& operator=(ChunkedStack&& src)
+    {
+        ChunkedStack tmp(std::move(src));
+        swap(tmp);
+        return *this;
+    }
+
     ~ChunkedStack()
     {
         this->releaseAllObjects(0);
@@ -41,17 +55,54 @@ public:
     void pop()
     {
         this->emptyCheck();
+        removeTop();
+    }
 
-        auto index = getTailIndex();
-        this->releaseItem(this->_tail, index);
-        this->_count--;
+    // Варианты без исключений для опроса пустого стека. tryPeek()
+    // возвращает nullptr, если стек пуст; у PtrStack его не отличить от
+    // добавленного nullptr, для неё есть tryPopInto().
+    TPtr tryPeek()
+    {
+        return this->isEmpty() ? nullptr : this->_tail->getItem(getTailIndex());
+    }
 
-        if (index == 0 && this->_tail != this->_head) {
-            auto prev = getTailPrev();
-            prev->next = nullptr;
-            this->_pool.release(this->_tail, false);
-            this->_tail = prev;
+    bool tryPop()
+    {
+        if (this->isEmpty()) {
+            return false;
         }
+
+        removeTop();
+        return true;
+    }
+
+    // Перемещает верхний элемент в out и удаляет его.
+    bool tryPopInto(T& out)
+    {
+        if (this->isEmpty()) {
+            return false;
+        }
+
+        out = std::move(this->itemValue(this->_tail, getTailIndex()));
+        removeTop();
+        return true;
+    }
+
+    // Добавляет count элементов из values, см. appendRange().
+    void pushN(const T* values, int count)
+    {
+        this->appendItems(0, values, values + count);
+    }
+
+    // Переносит до maxCount верхних элементов в out - массив уже
+    // созданных объектов - в порядке добавления, то есть верхний
+    // последним. Возвращает их кол-во. Опустевшие пачки возвращаются
+    // пулу разом.
+    int popN(T* out, int maxCount)
+    {
+        int count = std::min(maxCount, this->_count);
+        this->takeBack(count, out);
+        return count;
     }
 
     void clear()
@@ -59,14 +110,64 @@ public:
         this->clearAllItems(0);
     }
 
+    // Обмен содержимым за O(1).
+    void swap(ChunkedStack& other)
+    {
+        this->swapItems(other);
+    }
+
+    // Добавляет копии [first, last), из массива тривиально копируемых
+    // элементов - memcpy по пачке за раз.
+    template<class InputIt>
+    void appendRange(InputIt first, InputIt last)
+    {
+        this->appendItems(0, first, last);
+    }
+
+    // Копирует элементы по порядку в out, возвращает out за последним.
+    template<class OutputIt>
+    OutputIt copyTo(OutputIt out) const
+    {
+        return this->copyItems(0, out);
+    }
+
     Enumerator getEnumerator()
     {
         return this->getEnum(0);
     }
 
-    TArray toArray()
+    // Представление элементов без копирования, O(кол-ва пачек), см.
+    // ChunkedView.
+    View toArray()
+    {
+        return this->getView(0);
+    }
+
+    Iter begin()
+    {
+        return this->getBegin(0);
+    }
+
+    Iter end()
+    {
+        return this->getEnd();
+    }
+
+    ConstIter begin() const
+    {
+        return this->getBegin(0);
+    }
+
+    ConstIter end() const
+    {
+        return this->getEnd();
+    }
+
+    // func(first, n) для элементов каждой пачки, см. forEachSpan().
+    template<class Func>
+    void forEachChunk(Func func)
     {
-        return this->getArray(0);
+        this->forEachSpan(0, func);
     }
 private:
     int getTailIndex()
@@ -74,18 +175,18 @@ private:
         return (this->_count - 1) % ChunkSize;
     }
 
-    TChunk* getTailPrev()
+    void removeTop()
     {
-        if (this->_tail == this->_head) {
-            return this->_head;
-        }
+        auto index = getTailIndex();
+        this->releaseItem(this->_tail, index);
+        this->_count--;
 
-        auto current = this->_head;
-        while (current->next != this->_tail) {
-            current = current->next;
+        if (index == 0 && this->_tail != this->_head) {
+            auto prev = this->_tail->prev;
+            prev->next = nullptr;
+            this->_pool.release(this->_tail, false);
+            this->_tail = prev;
         }
-
-        return current;
     }
 };
 
@@ -97,10 +198,12 @@ private:
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize = Internal::DEF_CHUNK_SIZE>
-class ObjStack final : public Internal::ChunkedStack<T, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize = Internal::AUTO_CHUNK_SIZE,
+         size_t Align = alignof(T)>
+class ObjStack final
+    : public Internal::ChunkedStack<T, Alloc, Internal::chunkSizeFor<T, Align>(ChunkSize), Align>
 {
-    using Parent = Internal::ChunkedStack<T, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedStack<T, Alloc, Internal::chunkSizeFor<T, Align>(ChunkSize), Align>;
 
     static_assert(
         std::is_class<T>::value,
@@ -122,10 +225,11 @@ public:
 //
 //##############################################################################
 
-template<class T, class Alloc, size_t ChunkSize = Internal::DEF_CHUNK_SIZE>
-class PtrStack final : public Internal::ChunkedStack<T*, Alloc, ChunkSize>
+template<class T, class Alloc, size_t ChunkSize = Internal::AUTO_CHUNK_SIZE>
+class PtrStack final
+    : public Internal::ChunkedStack<T*, Alloc, Internal::chunkSizeFor<T*>(ChunkSize)>
 {
-    using Parent = Internal::ChunkedStack<T*, Alloc, ChunkSize>;
+    using Parent = Internal::ChunkedStack<T*, Alloc, Internal::chunkSizeFor<T*>(ChunkSize)>;
 
     static_assert(
         std::is_class<T>::value,
@@ -138,6 +242,16 @@ public:
     {
         this->appendItem(value);
     }
+
+    // Переносит в builder столько верхних элементов, сколько в нём
+    // поместится, в порядке добавления, как popN().
+    template<class BuilderAlloc>
+    int drainTo(ArrayBuilder<T, BuilderAlloc>& builder)
+    {
+        int count = std::min(this->count(), builder.limitCount() - builder.count());
+        this->takeBack(count, builder.inserter());
+        return count;
+    }
 };
 
 }
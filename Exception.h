@@ -121,6 +121,14 @@ void raiseT(Args&&... args)
 //
 //##############################################################################
 
+// Функция только для ошибок: не встраивается, а переходы к ней
+// считаются маловероятными.
+#ifdef MSVC
+#define COLD __declspec(noinline)
+#else
+#define COLD __attribute__((cold, noinline))
+#endif
+
 #define CHECK_NULL_PTR(ptr) \
     if (!(ptr)) { \
         Exceptions::Internal::raiseNullPointerException( \
@@ -3,6 +3,8 @@
 #include "Align.h"
 #include "Memory.h"
 
+#include <algorithm>
+
 struct RgnInfo
 {
     RgnInfo* prev;
@@ -10,10 +12,8 @@ struct RgnInfo
     uintptr_t last;
 };
 
-RgnInfo* allocRegion(size_t size, size_t headerSize, RgnInfo* prev)
+RgnInfo* initRegion(void* rgn, size_t size, size_t headerSize, RgnInfo* prev)
 {
-    void* rgn = RegionAllocator::alloc(size);
-
     RgnInfo* info = reinterpret_cast<RgnInfo*>(rgn);
     info->pos = Memory::ptrIntInc(rgn, alignToDefault(headerSize));
     info->last = Memory::ptrIntInc(rgn, size);
@@ -22,7 +22,14 @@ RgnInfo* allocRegion(size_t size, size_t headerSize, RgnInfo* prev)
     return info;
 }
 
+RgnInfo* allocRegion(size_t size, size_t headerSize, RgnInfo* prev)
+{
+    void* rgn = RegionAllocator::alloc(size);
+    return initRegion(rgn, size, headerSize, prev);
+}
+
 const int DEFAULT_INIT_SIZE = 65536 * 2; // 64kb
+const int DEFAULT_CHILD_INIT_SIZE = 1024;
 const size_t RGN_INFO_SIZE = alignToDefault(sizeof(RgnInfo));
 
 //##############################################################################
@@ -34,10 +41,14 @@ const size_t RGN_INFO_SIZE = alignToDefault(sizeof(RgnInfo));
 class LinearAllocatorPrivate
 {
 public:
-    LinearAllocatorPrivate(bool cleansable, RgnInfo* start)
+    LinearAllocatorPrivate(bool cleansable, RgnInfo* start,
+                           LinearAllocatorPrivate* parent)
     {
         _start = start;
         _current = start;
+        _cache = nullptr;
+        _parent = parent;
+        _startPos = start->pos;
         _cleansable = cleansable;
     }
 
@@ -59,16 +70,33 @@ public:
             return allocInCurrent(pos, size);
         }
         else {
-            return allocInNew(pos, size);
+            return allocInNew(size, align);
         }
     }
 
+    void reset()
+    {
+        releaseRegions();
+        _current = _start;
+        _start->pos = _startPos;
+    }
+
     void clear()
     {
+        if (_parent) {
+            // первый регион содержит this, поэтому возвращается последним
+            releaseRegions();
+            _parent->returnRegion(_start);
+            return;
+        }
+
         if (!_cleansable) {
             return;
         }
 
+        freeRegions(_cache);
+
+        // первый регион содержит this, поэтому освобождается последним
         RgnInfo* current = _current;
         while (current) {
             RgnInfo* prev = current->prev;
@@ -77,6 +105,33 @@ public:
         }
     }
 
+    // Регион для дочернего аллокатора, размер не меньше size.
+    RgnInfo* borrowRegion(size_t size)
+    {
+        RgnInfo* result = takeCached(size);
+        if (result) {
+            return result;
+        }
+
+        if (_parent) {
+            return _parent->borrowRegion(size);
+        }
+
+        return allocRegion(std::max<size_t>(size, DEFAULT_INIT_SIZE), RGN_INFO_SIZE, nullptr);
+    }
+
+    // Принимает регион, ранее выданный через borrowRegion.
+    void returnRegion(RgnInfo* rgn)
+    {
+        if (_parent) {
+            _parent->returnRegion(rgn);
+            return;
+        }
+
+        rgn->prev = _cache;
+        _cache = rgn;
+    }
+
 private:
     LinearAllocatorPrivate(LinearAllocatorPrivate&) = delete;
     LinearAllocatorPrivate(LinearAllocatorPrivate&&) = delete;
@@ -84,10 +139,13 @@ private:
     LinearAllocatorPrivate(const LinearAllocatorPrivate&&) = delete;
     void* operator new (size_t) = delete;
 
-    void* allocInNew(uintptr_t pos, size_t size)
+    void* allocInNew(size_t size, size_t align)
     {
-        _current = allocRegion(DEFAULT_INIT_SIZE, RGN_INFO_SIZE, _current);
-        return allocInCurrent(_current->pos, size);
+        RgnInfo* rgn = borrowRegion(RGN_INFO_SIZE + size + align);
+        rgn->prev = _current;
+        _current = rgn;
+
+        return allocInCurrent(alignValue(_current->pos, align), size);
     }
 
     void* allocInCurrent(uintptr_t pos, size_t size)
@@ -96,8 +154,58 @@ private:
         return reinterpret_cast<void*>(pos);
     }
 
+    RgnInfo* takeCached(size_t size)
+    {
+        RgnInfo* prev = nullptr;
+        RgnInfo* current = _cache;
+        while (current) {
+            uintptr_t start = Memory::ptrIntInc(current, RGN_INFO_SIZE);
+            if (current->last - start >= size) {
+                if (prev) {
+                    prev->prev = current->prev;
+                }
+                else {
+                    _cache = current->prev;
+                }
+
+                current->pos = start;
+                current->prev = nullptr;
+                return current;
+            }
+
+            prev = current;
+            current = current->prev;
+        }
+
+        return nullptr;
+    }
+
+    // Отдает все регионы кроме первого в кэш или родителю.
+    void releaseRegions()
+    {
+        RgnInfo* current = _current;
+        while (current != _start) {
+            RgnInfo* prev = current->prev;
+            returnRegion(current);
+            current = prev;
+        }
+    }
+
+    void freeRegions(RgnInfo* current)
+    {
+        while (current) {
+            RgnInfo* prev = current->prev;
+            RegionAllocator::free(current);
+            current = prev;
+        }
+    }
+
     RgnInfo* _start;
     RgnInfo* _current;
+    // свободные регионы, возвращенные дочерними аллокаторами и reset
+    RgnInfo* _cache;
+    LinearAllocatorPrivate* _parent;
+    uintptr_t _startPos;
     bool _cleansable;
 };
 
@@ -114,7 +222,17 @@ void* createPrivateData(bool cleansable, size_t initSize)
 {
     auto info = allocRegion(initSize, PRIVATE_SIZE + RGN_INFO_SIZE, nullptr);
     auto privateZone = Memory::ptrInc(info, RGN_INFO_SIZE);
-    auto allocator = new (privateZone) LinearAllocatorPrivate(cleansable, info);
+    auto allocator = new (privateZone) LinearAllocatorPrivate(cleansable, info, nullptr);
+    return allocator;
+}
+
+void* createChildData(LinearAllocatorPrivate* parent, size_t initSize)
+{
+    // первый регион тоже одалживается, чтобы вернуть его при разрушении
+    auto info = parent->borrowRegion(PRIVATE_SIZE + initSize);
+    auto privateZone = reinterpret_cast<void*>(info->pos);
+    info->pos += PRIVATE_SIZE;
+    auto allocator = new (privateZone) LinearAllocatorPrivate(true, info, parent);
     return allocator;
 }
 
@@ -132,6 +250,18 @@ STLinearAllocator::STLinearAllocator(bool cleansable, size_t initSize)
     data = createPrivateData(cleansable, initSize);
 }
 
+STLinearAllocator::STLinearAllocator(STLinearAllocator& parent)
+{
+    auto parentData = reinterpret_cast<LinearAllocatorPrivate*>(parent.data);
+    data = createChildData(parentData, DEFAULT_CHILD_INIT_SIZE);
+}
+
+STLinearAllocator::STLinearAllocator(STLinearAllocator& parent, size_t initSize)
+{
+    auto parentData = reinterpret_cast<LinearAllocatorPrivate*>(parent.data);
+    data = createChildData(parentData, initSize);
+}
+
 STLinearAllocator::~STLinearAllocator()
 {
     reinterpret_cast<LinearAllocatorPrivate*>(data)->clear();
@@ -147,3 +277,8 @@ void* STLinearAllocator::alloc(size_t size, size_t align)
 {
     return reinterpret_cast<LinearAllocatorPrivate*>(data)->alloc(size, align);
 }
+
+void STLinearAllocator::reset()
+{
+    reinterpret_cast<LinearAllocatorPrivate*>(data)->reset();
+}
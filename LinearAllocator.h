@@ -8,10 +8,22 @@ class STLinearAllocator
 public:
     STLinearAllocator(bool cleansable);
     STLinearAllocator(bool cleansable, size_t initSize);
+
+    // Дочерний аллокатор для вложенного времени жизни. Все регионы, включая
+    // первый, одалживаются у родителя; первый возвращается при разрушении,
+    // остальные - при reset и разрушении.
+    // Дочерний аллокатор должен быть разрушен раньше родителя и до его reset.
+    explicit STLinearAllocator(STLinearAllocator& parent);
+    STLinearAllocator(STLinearAllocator& parent, size_t initSize);
+
     ~STLinearAllocator();
 
     void* alloc(size_t size);
     void* alloc(size_t size, size_t align);
+
+    // Сбрасывает все выделения. Первый регион остается, остальные уходят
+    // в кэш (у дочернего аллокатора - родителю).
+    void reset();
 private:
     void* data;
 };
@@ -4,6 +4,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef MSVC
+#include <xmmintrin.h>
+#endif
+
 class Memory
 {
 public:
@@ -13,8 +17,20 @@ public:
 
     static void* allocRegion(size_t& size);
 
+    // Пытается выделить регион по адресу hint, если адрес занят, регион
+    // выделяется в другом месте.
+    static void* allocRegion(size_t& size, void* hint);
+
+    // Выделяет регион, начало которого выровнено на align (степень двойки,
+    // кратная размеру страницы).
+    static void* allocAlignedRegion(size_t& size, size_t align);
+
     static void freeRegion(void* region, size_t size);
 
+    // Отображает первые size байт файла поверх начала региона address.
+    // Изменения памяти в файл не попадают. Файл короче size - ошибка.
+    static void mapFile(const char* path, void* address, size_t size);
+
     static void* ptrInc(void* value, size_t size) {
         return static_cast<uint8_t*>(value) + size;
     }
@@ -33,6 +49,16 @@ public:
         return static_cast<char*>(value) - size;
     }
 
+    // Просит процессор заранее загрузить строку кэша с адресом address.
+    // Обращения к памяти нет, поэтому address может быть любым, даже nullptr.
+    static void prefetch(const void* address) {
+#ifdef MSVC
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        __builtin_prefetch(address);
+#endif
+    }
+
 private:
     Memory() = delete;
 };
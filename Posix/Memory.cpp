@@ -5,7 +5,9 @@
 
 #include <atomic>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 
 namespace MemoryInternal {
@@ -30,11 +32,16 @@ size_t Memory::getPageSize()
 }
 
 void* Memory::allocRegion(size_t& size)
+{
+    return allocRegion(size, nullptr);
+}
+
+void* Memory::allocRegion(size_t& size, void* hint)
 {
     size = alignValue(size, _pageSize);
 
     void* region = mmap(
-        0,
+        hint,
         size,
         PROT_READ | PROT_WRITE,
         MAP_ANONYMOUS | MAP_PRIVATE,
@@ -51,6 +58,47 @@ void* Memory::allocRegion(size_t& size)
     return region;
 }
 
+void* Memory::allocAlignedRegion(size_t& size, size_t align)
+{
+    if (align <= _pageSize) {
+        return allocRegion(size);
+    }
+
+    size = alignValue(size, _pageSize);
+    size_t reserved = size + align - _pageSize;
+
+    void* region = mmap(
+        0,
+        reserved,
+        PROT_READ | PROT_WRITE,
+        MAP_ANONYMOUS | MAP_PRIVATE,
+        -1,
+        0
+    );
+
+    if (region == MAP_FAILED) {
+        RAISE(BadAllocException,
+            "mmap failed with reason: " + getLastErrorMessage()
+        );
+    }
+
+    // отрезаем лишнее в начале и в конце резерва
+    void* aligned = alignValue(region, align);
+    size_t head = reinterpret_cast<uintptr_t>(aligned)
+        - reinterpret_cast<uintptr_t>(region);
+    size_t tail = reserved - head - size;
+
+    if (head != 0) {
+        munmap(region, head);
+    }
+
+    if (tail != 0) {
+        munmap(ptrInc(aligned, size), tail);
+    }
+
+    return aligned;
+}
+
 void Memory::freeRegion(void* region, size_t size)
 {
     if (munmap(region, size) != 0) {
@@ -59,3 +107,37 @@ void Memory::freeRegion(void* region, size_t size)
         );
     }
 }
+
+void Memory::mapFile(const char* path, void* address, size_t size)
+{
+    int file = open(path, O_RDONLY);
+    if (file == -1) {
+        RAISE(RuntimeException,
+            "open failed with reason: " + getLastErrorMessage()
+        );
+    }
+
+    // хвост за концом файла дал бы SIGBUS при первом обращении
+    struct stat info;
+    if (fstat(file, &info) != 0 || uint64_t(info.st_size) < size) {
+        close(file);
+        RAISE(RuntimeException, "File is shorter than mapped size");
+    }
+
+    void* region = mmap(
+        address,
+        size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_FIXED,
+        file,
+        0
+    );
+
+    close(file);
+
+    if (region == MAP_FAILED) {
+        RAISE(BadAllocException,
+            "mmap failed with reason: " + getLastErrorMessage()
+        );
+    }
+}
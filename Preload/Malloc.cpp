@@ -0,0 +1,386 @@
+﻿// Замена malloc для LD_PRELOAD. Мелкие блоки выделяются из слэбов
+// STSlabAllocator потока, крупные - отдельными регионами RegionAllocator.
+// Блок, освобожденный в чужом потоке, возвращается владельцу через его
+// lock-free список. Аллокатор завершившегося потока не разрушается,
+// он попадает в список брошенных и достается следующему новому потоку.
+// Вызовы, пришедшие из потока после этого (например, из других TLS
+// деструкторов), обслуживает общий аллокатор под блокировкой.
+
+#include "../SlabAllocator.h"
+#include "../RegionAllocator.h"
+#include "../Memory.h"
+#include "../Align.h"
+
+#include <new>
+#include <mutex>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+
+#define EXPORT_CPP __attribute__((visibility("default")))
+#define EXPORT extern "C" EXPORT_CPP
+
+namespace PreloadInternal {
+
+    struct Heap
+    {
+        STSlabAllocator allocator;
+        Heap* next;
+    };
+
+    // аллокатор текущего потока
+    __thread Heap* _heap __attribute__((tls_model("initial-exec"))) = nullptr;
+    // поток уже отдал свой аллокатор в список брошенных
+    __thread bool _tornDown __attribute__((tls_model("initial-exec"))) = false;
+    // счетчик free потока, по нему периодически чистятся брошенные аллокаторы
+    __thread unsigned _releaseCount __attribute__((tls_model("initial-exec"))) = 0;
+
+    // через сколько free поток проверяет брошенные аллокаторы
+    const unsigned COLLECT_PERIOD = 4096;
+
+    // аллокаторы завершившихся потоков
+    Heap* _abandoned = nullptr;
+    std::mutex _abandonedLock;
+
+    // аллокатор для вызовов из завершившихся потоков
+    Heap* _shared = nullptr;
+    std::mutex _sharedLock;
+
+    pthread_key_t _heapKey;
+    pthread_once_t _heapKeyOnce = PTHREAD_ONCE_INIT;
+
+    // Освобождает блоки, которые другие потоки вернули брошенным
+    // аллокаторам. Иначе они ждут, пока аллокатор достанется новому потоку.
+    // Вызывается под _abandonedLock.
+    void releaseAbandoned()
+    {
+        for (Heap* heap = _abandoned; heap; heap = heap->next) {
+            heap->allocator.releaseRemote();
+        }
+    }
+
+    void collectAbandoned()
+    {
+        std::unique_lock<std::mutex> lock(_abandonedLock, std::try_to_lock);
+        if (lock.owns_lock()) {
+            releaseAbandoned();
+        }
+
+        std::unique_lock<std::mutex> sharedLock(_sharedLock, std::try_to_lock);
+        if (sharedLock.owns_lock() && _shared) {
+            _shared->allocator.releaseRemote();
+        }
+    }
+
+    void abandonHeap(void* value)
+    {
+        auto heap = static_cast<Heap*>(value);
+        // после этого pthread_setspecific больше не вызывается, иначе
+        // поздний malloc создал бы новый аллокатор, который некому вернуть
+        _heap = nullptr;
+        _tornDown = true;
+
+        std::lock_guard<std::mutex> lock(_abandonedLock);
+        heap->next = _abandoned;
+        _abandoned = heap;
+        releaseAbandoned();
+    }
+
+    // Блокировки берутся на время fork(), иначе в дочернем процессе
+    // они могли бы остаться занятыми потоками, которых там нет.
+    void lockBeforeFork()
+    {
+        _abandonedLock.lock();
+        _sharedLock.lock();
+    }
+
+    void unlockAfterFork()
+    {
+        _sharedLock.unlock();
+        _abandonedLock.unlock();
+    }
+
+    void initProcess()
+    {
+        Memory::init();
+        pthread_key_create(&_heapKey, &abandonHeap);
+        pthread_atfork(&lockBeforeFork, &unlockAfterFork, &unlockAfterFork);
+    }
+
+    inline void ensureInit()
+    {
+        pthread_once(&_heapKeyOnce, &initProcess);
+    }
+
+    Heap* createHeap()
+    {
+        ensureInit();
+
+        Heap* heap = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_abandonedLock);
+            if (_abandoned) {
+                heap = _abandoned;
+                _abandoned = heap->next;
+            }
+        }
+
+        if (heap == nullptr) {
+            size_t size = sizeof(Heap);
+            heap = new (RegionAllocator::alloc(size)) Heap();
+        }
+
+        // pthread_setspecific может позвать calloc, поэтому _heap
+        // назначается раньше
+        _heap = heap;
+        pthread_setspecific(_heapKey, heap);
+        return heap;
+    }
+
+    // Аллокатор потока, nullptr если поток уже завершается.
+    inline Heap* getHeap()
+    {
+        Heap* heap = _heap;
+        if (heap == nullptr && !_tornDown) {
+            heap = createHeap();
+        }
+
+        return heap;
+    }
+
+    // Вызывается под _sharedLock.
+    STSlabAllocator& getSharedAllocator()
+    {
+        if (_shared == nullptr) {
+            size_t size = sizeof(Heap);
+            _shared = new (RegionAllocator::alloc(size)) Heap();
+        }
+
+        return _shared->allocator;
+    }
+
+    inline bool isPowerOfTwo(size_t value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    void* allocate(size_t size, size_t align)
+    {
+        try {
+            Heap* heap = getHeap();
+            if (heap) {
+                return heap->allocator.alloc(size, align);
+            }
+
+            std::lock_guard<std::mutex> lock(_sharedLock);
+            return getSharedAllocator().alloc(size, align);
+        }
+        catch (...) {
+            errno = ENOMEM;
+            return nullptr;
+        }
+    }
+
+    void release(void* ptr)
+    {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        try {
+            Heap* heap = getHeap();
+            if (heap) {
+                heap->allocator.free(ptr);
+            }
+            else {
+                std::lock_guard<std::mutex> lock(_sharedLock);
+                getSharedAllocator().free(ptr);
+            }
+        }
+        catch (...) {
+        }
+
+        if (++_releaseCount % COLLECT_PERIOD == 0) {
+            collectAbandoned();
+        }
+    }
+
+    void* reallocate(void* ptr, size_t size)
+    {
+        if (ptr == nullptr) {
+            return allocate(size, DEFAULT_ALIGN);
+        }
+
+        if (size == 0) {
+            release(ptr);
+            return nullptr;
+        }
+
+        size_t oldSize = STSlabAllocator::getSize(ptr);
+        if (size <= oldSize) {
+            return ptr;
+        }
+
+        void* result = allocate(size, DEFAULT_ALIGN);
+        if (result) {
+            memcpy(result, ptr, oldSize);
+            release(ptr);
+        }
+
+        return result;
+    }
+}
+
+using namespace PreloadInternal;
+
+//##############################################################################
+//
+// C API
+//
+//##############################################################################
+
+EXPORT void* malloc(size_t size)
+{
+    return allocate(size, 2 * DEFAULT_ALIGN);
+}
+
+EXPORT void free(void* ptr)
+{
+    release(ptr);
+}
+
+EXPORT void cfree(void* ptr)
+{
+    release(ptr);
+}
+
+EXPORT void* calloc(size_t count, size_t size)
+{
+    size_t total = count * size;
+    if (size != 0 && total / size != count) {
+        errno = ENOMEM;
+        return nullptr;
+    }
+
+    void* result = allocate(total, 2 * DEFAULT_ALIGN);
+    if (result) {
+        memset(result, 0, total);
+    }
+
+    return result;
+}
+
+EXPORT void* realloc(void* ptr, size_t size)
+{
+    return reallocate(ptr, size);
+}
+
+EXPORT void* memalign(size_t align, size_t size)
+{
+    if (!isPowerOfTwo(align)) {
+        errno = EINVAL;
+        return nullptr;
+    }
+
+    return allocate(size, align);
+}
+
+EXPORT void* aligned_alloc(size_t align, size_t size)
+{
+    return memalign(align, size);
+}
+
+EXPORT int posix_memalign(void** result, size_t align, size_t size)
+{
+    if (!isPowerOfTwo(align) || align % sizeof(void*) != 0) {
+        return EINVAL;
+    }
+
+    void* ptr = allocate(size, align);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+
+    *result = ptr;
+    return 0;
+}
+
+EXPORT void* valloc(size_t size)
+{
+    // размер страницы известен после Memory::init()
+    ensureInit();
+    return allocate(size, Memory::getPageSize());
+}
+
+EXPORT void* pvalloc(size_t size)
+{
+    ensureInit();
+    size_t pageSize = Memory::getPageSize();
+    return allocate(alignValue(size, pageSize), pageSize);
+}
+
+EXPORT size_t malloc_usable_size(void* ptr)
+{
+    return ptr ? STSlabAllocator::getSize(ptr) : 0;
+}
+
+//##############################################################################
+//
+// C++ API
+//
+//##############################################################################
+
+EXPORT_CPP void* operator new(size_t size)
+{
+    void* result = allocate(size, 2 * DEFAULT_ALIGN);
+    if (result == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return result;
+}
+
+EXPORT_CPP void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+EXPORT_CPP void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size, 2 * DEFAULT_ALIGN);
+}
+
+EXPORT_CPP void* operator new[](size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+EXPORT_CPP void operator delete(void* ptr) noexcept
+{
+    release(ptr);
+}
+
+EXPORT_CPP void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+EXPORT_CPP void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+EXPORT_CPP void operator delete[](void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+EXPORT_CPP void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+EXPORT_CPP void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
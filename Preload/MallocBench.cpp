@@ -0,0 +1,163 @@
+﻿// Синтетическая нагрузка на malloc. Запускается как есть и с
+// LD_PRELOAD=libGreedyMalloc.so (см. bench_preload.sh).
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+using namespace std::chrono;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+static int _threadCount = 4;
+static int _count = 2000000;
+static const int _slotCount = 8192;
+static const int _batchSize = 256;
+
+static uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static size_t randomSize(uint32_t& state)
+{
+    uint32_t value = nextRandom(state);
+
+    // 1 из 256 блоков крупный
+    if (value % 256 == 0) {
+        return 4096 + value % 65536;
+    }
+
+    return 8 + value % 1024;
+}
+
+// Выделения и освобождения в одном потоке вперемешку с контейнерами STL.
+void churnThread(uint32_t seed)
+{
+    vector<void*> slots(_slotCount, nullptr);
+    uint32_t state = seed;
+
+    for (int i = 0; i < _count; i++) {
+        int slot = nextRandom(state) % _slotCount;
+        free(slots[slot]);
+        slots[slot] = malloc(randomSize(state));
+
+        if (i % 64 == 0) {
+            string text(nextRandom(state) % 200, 'x');
+            vector<int> values(nextRandom(state) % 100, i);
+            slots[slot] = realloc(slots[slot], text.size() + values.size() + 1);
+        }
+    }
+
+    for (auto ptr : slots) {
+        free(ptr);
+    }
+}
+
+// Производитель выделяет блоки, потребитель освобождает их в другом потоке.
+struct Exchange
+{
+    mutex lock;
+    vector<vector<void*>> batches;
+    bool done = false;
+};
+
+void producerThread(Exchange* exchange, uint32_t seed)
+{
+    uint32_t state = seed;
+    vector<void*> batch;
+
+    for (int i = 0; i < _count / 2; i++) {
+        batch.push_back(malloc(randomSize(state)));
+        if (batch.size() == _batchSize) {
+            lock_guard<mutex> guard(exchange->lock);
+            exchange->batches.push_back(move(batch));
+            batch = vector<void*>();
+        }
+    }
+
+    lock_guard<mutex> guard(exchange->lock);
+    exchange->batches.push_back(move(batch));
+    exchange->done = true;
+}
+
+void consumerThread(Exchange* exchange)
+{
+    while (true) {
+        vector<vector<void*>> batches;
+        bool done;
+        {
+            lock_guard<mutex> guard(exchange->lock);
+            batches.swap(exchange->batches);
+            done = exchange->done;
+        }
+
+        for (auto& batch : batches) {
+            for (auto ptr : batch) {
+                free(ptr);
+            }
+        }
+
+        if (done && batches.empty()) {
+            return;
+        }
+
+        if (batches.empty()) {
+            this_thread::yield();
+        }
+    }
+}
+
+template<class Func>
+void measure(const char* name, Func func)
+{
+    Time startTime = high_resolution_clock::now();
+    func();
+    Time endTime = high_resolution_clock::now();
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1) {
+        _threadCount = atoi(argv[1]);
+    }
+
+    if (argc > 2) {
+        _count = atoi(argv[2]);
+    }
+
+    measure("churn", [] {
+        vector<thread> threads;
+        for (int i = 0; i < _threadCount; i++) {
+            threads.emplace_back(&churnThread, i + 1);
+        }
+
+        for (auto& th : threads) {
+            th.join();
+        }
+    });
+
+    measure("producer/consumer", [] {
+        vector<Exchange> exchanges(_threadCount);
+        vector<thread> threads;
+        for (int i = 0; i < _threadCount; i++) {
+            threads.emplace_back(&producerThread, &exchanges[i], i + 1);
+            threads.emplace_back(&consumerThread, &exchanges[i]);
+        }
+
+        for (auto& th : threads) {
+            th.join();
+        }
+    });
+
+    return 0;
+}
@@ -96,6 +96,14 @@ void* RegionAllocator::alloc(size_t& size)
     return region;
 }
 
+void* RegionAllocator::alloc(size_t& size, size_t align)
+{
+    void* region = Memory::allocAlignedRegion(size, align);
+    region = initRegion(region, size);
+    size -= HEADER_SIZE;
+    return region;
+}
+
 void RegionAllocator::free(void* region)
 {
     Header* header = getHeader(region);
@@ -107,3 +115,14 @@ size_t RegionAllocator::getSize(void* region)
     Header* header = getHeader(region);
     return header->byteCount;
 }
+
+void* RegionAllocator::find(void* address, size_t align)
+{
+    ASSERT((align & (align - 1)) == 0, "Align must be power of two");
+
+    uintptr_t start = reinterpret_cast<uintptr_t>(address) & ~(align - 1);
+    Header* header = reinterpret_cast<Header*>(start);
+    checkMagic(&header->magicWord[0]);
+
+    return Memory::ptrInc(header, HEADER_SIZE);
+}
@@ -10,12 +10,20 @@ public:
     // При выделении размер округляется до гранулярности стриниц в системе.
     static void* alloc(size_t& size);
 
+    // Выделяет регион, начало которого выровнено на align. Такой регион
+    // можно найти по любому адресу внутри первых align байт через find.
+    static void* alloc(size_t& size, size_t align);
+
     // Освобождяет указанный регион. Параметр region должен быть равен
     // реузультату alloc.
     static void free(void* region);
 
     //
     static size_t getSize(void* region);
+
+    // Возвращает регион, выделенный через alloc(size, align), по адресу
+    // внутри него. Адрес должен лежать в первых align байтах региона.
+    static void* find(void* address, size_t align);
 private:
     // static only class
     RegionAllocator() = delete;
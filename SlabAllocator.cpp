@@ -0,0 +1,537 @@
+﻿#include "SlabAllocator.h"
+#include "RegionAllocator.h"
+#include "Exception.h"
+#include "Debug.h"
+#include "Align.h"
+#include "Bits.h"
+#include "Memory.h"
+
+#include <new>
+#include <atomic>
+#include <algorithm>
+#include <stdint.h>
+
+namespace SlabAllocatorInternal {
+
+    // размер слэба, слэбы выровнены на свой размер
+    const size_t SLAB_SIZE = 65536;
+    // выравнивание начала данных в слэбе
+    const size_t DATA_ALIGN = 64;
+    // шаг классов размеров
+    const size_t MIN_SIZE = 16;
+    // максимальный размер объекта, который берется из слэба
+    const size_t MAX_SMALL_SIZE = 8192;
+    // максимальное выравнивание для крупных блоков
+    const size_t MAX_LARGE_ALIGN = SLAB_SIZE / 2;
+    // кол-во пустых слэбов, которые держим в кэше
+    const int MAX_CACHED_SLABS = 8;
+    // кол-во освобожденных крупных регионов, которые держим в кэше
+    const int MAX_CACHED_LARGE = 8;
+    // максимальный размер крупного региона для кэша
+    const size_t MAX_CACHED_LARGE_SIZE = 1024 * 1024;
+
+    // до 128 байт шаг 16, дальше по 4 класса на удвоение
+    const int CLASS_COUNT = 32;
+    const uint32_t CLASS_SIZES[CLASS_COUNT] = {
+        16, 32, 48, 64, 80, 96, 112, 128,
+        160, 192, 224, 256, 320, 384, 448, 512,
+        640, 768, 896, 1024, 1280, 1536, 1792, 2048,
+        2560, 3072, 3584, 4096, 5120, 6144, 7168, 8192
+    };
+
+    // слов в битовой карте занятости, хватает на слэб из 16-байтовых объектов
+    const int BITMAP_WORDS = SLAB_SIZE / MIN_SIZE / 64;
+
+    enum class BlockKind : uint32_t
+    {
+        Small = 0x51AB,
+        Large = 0xB16B
+    };
+
+    struct SizeClass;
+
+    // Общее начало заголовков слэба и крупного блока
+    struct BlockHeader
+    {
+        BlockKind kind;
+        uint32_t reserved;
+        void* owner;
+    };
+
+    // Заголовок слэба. Бит в bitmap установлен для свободной ячейки, бит в
+    // summary - для слова bitmap, в котором есть свободные ячейки. Поиск
+    // свободной ячейки - два bit scan.
+    struct Slab
+    {
+        BlockHeader header;
+        Slab* prev;
+        Slab* next;
+        SizeClass* sizeClass;
+        uint32_t objSize;
+        uint8_t* data;
+        uint8_t* limit;
+        uint32_t capacity;
+        uint32_t used;
+        uint64_t summary;
+        uint64_t bitmap[BITMAP_WORDS];
+    };
+
+    struct LargeBlock
+    {
+        BlockHeader header;
+        LargeBlock* prev;
+        LargeBlock* next;
+        size_t size;
+    };
+
+    struct SizeClass
+    {
+        uint32_t objSize;
+        // слэбы со свободными ячейками
+        Slab* partial;
+        // заполненные слэбы
+        Slab* full;
+    };
+
+
+    template<class T>
+    void pushFront(T*& head, T* item)
+    {
+        item->prev = nullptr;
+        item->next = head;
+        if (head) {
+            head->prev = item;
+        }
+
+        head = item;
+    }
+
+    template<class T>
+    void unlink(T*& head, T* item)
+    {
+        if (item->prev) {
+            item->prev->next = item->next;
+        }
+        else {
+            head = item->next;
+        }
+
+        if (item->next) {
+            item->next->prev = item->prev;
+        }
+
+        item->prev = nullptr;
+        item->next = nullptr;
+    }
+
+    BlockHeader* getHeader(void* ptr)
+    {
+        return reinterpret_cast<BlockHeader*>(RegionAllocator::find(ptr, SLAB_SIZE));
+    }
+}
+
+using namespace SlabAllocatorInternal;
+
+//##############################################################################
+//
+// SlabAllocatorPrivate
+//
+//##############################################################################
+
+class SlabAllocatorPrivate
+{
+public:
+    SlabAllocatorPrivate()
+    {
+        _cache = nullptr;
+        _cacheCount = 0;
+        _large = nullptr;
+        _largeCache = nullptr;
+        _largeCacheCount = 0;
+        _remote.store(nullptr);
+
+        int classIndex = 0;
+        for (int i = 0; i < CLASS_COUNT; i++) {
+            _classes[i].objSize = CLASS_SIZES[i];
+            _classes[i].partial = nullptr;
+            _classes[i].full = nullptr;
+        }
+
+        for (size_t i = 0; i <= MAX_SMALL_SIZE / MIN_SIZE; i++) {
+            while (CLASS_SIZES[classIndex] < i * MIN_SIZE) {
+                classIndex++;
+            }
+
+            _classIndex[i] = static_cast<uint8_t>(classIndex);
+        }
+    }
+
+    void* alloc(size_t size, size_t align)
+    {
+        if (_remote.load(std::memory_order_relaxed) != nullptr) {
+            releaseRemote();
+        }
+
+        if (size == 0) {
+            size = 1;
+        }
+
+        if (align <= MIN_SIZE) {
+            if (size <= MAX_SMALL_SIZE) {
+                return allocSmall(_classes[getClassIndex(size)]);
+            }
+        }
+        else if (align <= DATA_ALIGN) {
+            // ячейки выровнены на align только в классах кратных align
+            size = alignValue(size, align);
+            if (size <= MAX_SMALL_SIZE) {
+                int index = getClassIndex(size);
+                while (index < CLASS_COUNT && CLASS_SIZES[index] % align != 0) {
+                    index++;
+                }
+
+                if (index < CLASS_COUNT) {
+                    return allocSmall(_classes[index]);
+                }
+            }
+        }
+
+        return allocLarge(size, align);
+    }
+
+    void free(void* ptr)
+    {
+        if (ptr == nullptr) {
+            return;
+        }
+
+        BlockHeader* header = getHeader(ptr);
+        if (header->owner != this) {
+            // блок другого потока возвращаем владельцу
+            auto owner = static_cast<SlabAllocatorPrivate*>(header->owner);
+            owner->pushRemote(ptr);
+            return;
+        }
+
+        freeLocal(header, ptr);
+    }
+
+    void releaseRemote()
+    {
+        void* current = _remote.exchange(nullptr, std::memory_order_acquire);
+        while (current) {
+            void* next = *static_cast<void**>(current);
+            freeLocal(getHeader(current), current);
+            current = next;
+        }
+    }
+
+    static size_t getSize(void* ptr)
+    {
+        CHECK_NULL_ARG(ptr);
+
+        BlockHeader* header = getHeader(ptr);
+        switch (header->kind) {
+        case BlockKind::Small:
+            return reinterpret_cast<Slab*>(header)->objSize;
+        case BlockKind::Large: {
+            auto block = reinterpret_cast<LargeBlock*>(header);
+            auto offset = static_cast<uint8_t*>(ptr) - reinterpret_cast<uint8_t*>(block);
+            return block->size - offset;
+        }
+        default:
+            RAISE(ArgumentException, "Invalid block address");
+        }
+
+        return 0;
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < CLASS_COUNT; i++) {
+            freeSlabs(_classes[i].partial);
+            freeSlabs(_classes[i].full);
+        }
+
+        freeSlabs(_cache);
+        _cacheCount = 0;
+
+        freeLargeBlocks(_large);
+        freeLargeBlocks(_largeCache);
+        _largeCacheCount = 0;
+    }
+private:
+    SizeClass _classes[CLASS_COUNT];
+    uint8_t _classIndex[MAX_SMALL_SIZE / MIN_SIZE + 1];
+    Slab* _cache;
+    int _cacheCount;
+    LargeBlock* _large;
+    LargeBlock* _largeCache;
+    int _largeCacheCount;
+    // блоки, освобожденные другими потоками
+    std::atomic<void*> _remote;
+
+    void freeLocal(BlockHeader* header, void* ptr)
+    {
+        switch (header->kind) {
+        case BlockKind::Small:
+            freeSmall(reinterpret_cast<Slab*>(header), ptr);
+            break;
+        case BlockKind::Large:
+            freeLarge(reinterpret_cast<LargeBlock*>(header));
+            break;
+        default:
+            RAISE(ArgumentException, "Invalid block address");
+        }
+    }
+
+    void pushRemote(void* ptr)
+    {
+        auto link = static_cast<void**>(ptr);
+        void* head = _remote.load(std::memory_order_relaxed);
+        do {
+            *link = head;
+        } while (!_remote.compare_exchange_weak(
+            head, ptr, std::memory_order_release, std::memory_order_relaxed
+        ));
+    }
+
+    int getClassIndex(size_t size)
+    {
+        return _classIndex[(size + MIN_SIZE - 1) / MIN_SIZE];
+    }
+
+    void* allocSmall(SizeClass& sizeClass)
+    {
+        Slab* slab = sizeClass.partial;
+        if (slab == nullptr) {
+            slab = createSlab(sizeClass);
+            pushFront(sizeClass.partial, slab);
+        }
+
+        int word = countTrailingZeros(slab->summary);
+        uint64_t bits = slab->bitmap[word];
+        int bit = countTrailingZeros(bits);
+
+        bits &= bits - 1;
+        slab->bitmap[word] = bits;
+        if (bits == 0) {
+            slab->summary &= ~(uint64_t(1) << word);
+        }
+
+        slab->used++;
+        if (slab->used == slab->capacity) {
+            unlink(sizeClass.partial, slab);
+            pushFront(sizeClass.full, slab);
+        }
+
+        size_t index = static_cast<size_t>(word) * 64 + bit;
+        return slab->data + index * slab->objSize;
+    }
+
+    void freeSmall(Slab* slab, void* ptr)
+    {
+        size_t offset = static_cast<uint8_t*>(ptr) - slab->data;
+        size_t index = offset / slab->objSize;
+        ASSERT(offset % slab->objSize == 0, "Invalid block address");
+
+        size_t word = index / 64;
+        uint64_t mask = uint64_t(1) << (index % 64);
+        ASSERT((slab->bitmap[word] & mask) == 0, "Block already released");
+
+        SizeClass& sizeClass = *slab->sizeClass;
+        if (slab->used == slab->capacity) {
+            unlink(sizeClass.full, slab);
+            pushFront(sizeClass.partial, slab);
+        }
+
+        slab->bitmap[word] |= mask;
+        slab->summary |= uint64_t(1) << word;
+        slab->used--;
+
+        if (slab->used == 0) {
+            unlink(sizeClass.partial, slab);
+            releaseSlab(slab);
+        }
+    }
+
+    void* allocLarge(size_t size, size_t align)
+    {
+        if (align > MAX_LARGE_ALIGN) {
+            RAISE(ArgumentException, "Align is too big");
+        }
+
+        align = std::max(align, DATA_ALIGN);
+        size_t regionSize = sizeof(LargeBlock) + align + size;
+
+        auto block = takeCachedLarge(regionSize);
+        if (block == nullptr) {
+            block = reinterpret_cast<LargeBlock*>(
+                RegionAllocator::alloc(regionSize, SLAB_SIZE)
+            );
+        }
+        else {
+            regionSize = block->size;
+        }
+
+        block->header.kind = BlockKind::Large;
+        block->header.owner = this;
+        block->size = regionSize;
+        pushFront(_large, block);
+
+        return alignValue(Memory::ptrInc(block, sizeof(LargeBlock)), align);
+    }
+
+    void freeLarge(LargeBlock* block)
+    {
+        unlink(_large, block);
+
+        if (_largeCacheCount < MAX_CACHED_LARGE && block->size <= MAX_CACHED_LARGE_SIZE) {
+            pushFront(_largeCache, block);
+            _largeCacheCount++;
+            return;
+        }
+
+        RegionAllocator::free(block);
+    }
+
+    // Подходящий регион из кэша, не больше чем вдвое крупнее нужного.
+    LargeBlock* takeCachedLarge(size_t size)
+    {
+        LargeBlock* block = _largeCache;
+        while (block) {
+            if (block->size >= size && block->size / 2 <= size) {
+                unlink(_largeCache, block);
+                _largeCacheCount--;
+                return block;
+            }
+
+            block = block->next;
+        }
+
+        return nullptr;
+    }
+
+    void freeLargeBlocks(LargeBlock*& head)
+    {
+        while (head) {
+            auto next = head->next;
+            RegionAllocator::free(head);
+            head = next;
+        }
+    }
+
+    Slab* createSlab(SizeClass& sizeClass)
+    {
+        Slab* slab = _cache;
+        if (slab) {
+            _cache = slab->next;
+            _cacheCount--;
+        }
+        else {
+            size_t size = SLAB_SIZE;
+            slab = reinterpret_cast<Slab*>(RegionAllocator::alloc(size, SLAB_SIZE));
+            slab->data = static_cast<uint8_t*>(
+                alignValue(Memory::ptrInc(slab, sizeof(Slab)), DATA_ALIGN)
+            );
+            slab->limit = Memory::ptrInc<uint8_t>(slab, size);
+        }
+
+        slab->header.kind = BlockKind::Small;
+        slab->header.owner = this;
+        slab->sizeClass = &sizeClass;
+        slab->objSize = sizeClass.objSize;
+        slab->capacity = static_cast<uint32_t>(
+            (slab->limit - slab->data) / sizeClass.objSize
+        );
+        slab->used = 0;
+        slab->prev = nullptr;
+        slab->next = nullptr;
+
+        ASSERT(slab->capacity <= BITMAP_WORDS * 64);
+
+        int fullWords = slab->capacity / 64;
+        int restBits = slab->capacity % 64;
+        for (int i = 0; i < BITMAP_WORDS; i++) {
+            if (i < fullWords) {
+                slab->bitmap[i] = ~uint64_t(0);
+            }
+            else if (i == fullWords) {
+                slab->bitmap[i] = lowBitsMask(restBits);
+            }
+            else {
+                slab->bitmap[i] = 0;
+            }
+        }
+
+        slab->summary = lowBitsMask(fullWords + (restBits != 0 ? 1 : 0));
+        return slab;
+    }
+
+    void releaseSlab(Slab* slab)
+    {
+        if (_cacheCount < MAX_CACHED_SLABS) {
+            slab->next = _cache;
+            _cache = slab;
+            _cacheCount++;
+            return;
+        }
+
+        RegionAllocator::free(slab);
+    }
+
+    void freeSlabs(Slab*& head)
+    {
+        while (head) {
+            auto next = head->next;
+            RegionAllocator::free(head);
+            head = next;
+        }
+    }
+};
+
+//##############################################################################
+//
+// STSlabAllocator
+//
+//##############################################################################
+
+STSlabAllocator::STSlabAllocator()
+{
+    size_t size = sizeof(SlabAllocatorPrivate);
+    void* region = RegionAllocator::alloc(size);
+    data = new (region) SlabAllocatorPrivate();
+}
+
+STSlabAllocator::~STSlabAllocator()
+{
+    auto allocator = reinterpret_cast<SlabAllocatorPrivate*>(data);
+    allocator->clear();
+    allocator->~SlabAllocatorPrivate();
+    RegionAllocator::free(allocator);
+}
+
+void* STSlabAllocator::alloc(size_t size)
+{
+    return reinterpret_cast<SlabAllocatorPrivate*>(data)->alloc(size, DEFAULT_ALIGN);
+}
+
+void* STSlabAllocator::alloc(size_t size, size_t align)
+{
+    return reinterpret_cast<SlabAllocatorPrivate*>(data)->alloc(size, align);
+}
+
+void STSlabAllocator::free(void* ptr)
+{
+    reinterpret_cast<SlabAllocatorPrivate*>(data)->free(ptr);
+}
+
+void STSlabAllocator::releaseRemote()
+{
+    reinterpret_cast<SlabAllocatorPrivate*>(data)->releaseRemote();
+}
+
+size_t STSlabAllocator::getSize(void* ptr)
+{
+    return SlabAllocatorPrivate::getSize(ptr);
+}
@@ -0,0 +1,37 @@
+﻿#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H
+
+#include <stddef.h>
+
+// Однопоточный аллокатор с классами размеров. Объекты до 8kb нарезаются
+// из слэбов, выделенных через RegionAllocator, крупные блоки получают
+// собственный регион. В отличие от STLinearAllocator память
+// возвращается через free, опустевшие слэбы уходят в кэш регионов.
+class STSlabAllocator
+{
+public:
+    STSlabAllocator();
+    ~STSlabAllocator();
+
+    void* alloc(size_t size);
+    void* alloc(size_t size, size_t align);
+
+    // Освобождает блок. Блок другого экземпляра (например, выделенный в
+    // другом потоке) без блокировок передается владельцу и будет
+    // освобожден при его следующем alloc.
+    void free(void* ptr);
+
+    // Освобождает блоки, переданные другими экземплярами через free.
+    // Вызывается потоком, который сейчас владеет аллокатором.
+    void releaseRemote();
+
+    // Полезный размер блока, выделенного через alloc.
+    static size_t getSize(void* ptr);
+private:
+    STSlabAllocator(const STSlabAllocator&) = delete;
+    STSlabAllocator& operator = (const STSlabAllocator&) = delete;
+
+    void* data;
+};
+
+#endif // SLABALLOCATOR_H
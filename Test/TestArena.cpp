@@ -0,0 +1,269 @@
+﻿#include "TestArena.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <stdint.h>
+#include "../Arena.h"
+#include "../Exception.h"
+
+#ifdef OS_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace std::chrono;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+namespace {
+
+// Таблица поиска, которая строится при старте: хэш-таблица с цепочками.
+struct Entry
+{
+    uint64_t key;
+    uint64_t value;
+    Handle<Entry> next;
+};
+
+struct Table
+{
+    uint32_t bucketCount;
+    OffsetPtr<Handle<Entry>> buckets;
+    // обычный указатель, исправляется при загрузке по другому адресу
+    Entry* first;
+};
+
+static const char* _imagePath = "TestArena.img";
+static int _count = 1000000;
+
+uint64_t makeValue(uint64_t key)
+{
+    uint64_t value = key;
+    for (int i = 0; i < 16; i++) {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+    }
+
+    return value;
+}
+
+Table* buildTable(Arena& arena)
+{
+    auto table = static_cast<Table*>(arena.alloc(sizeof(Table)));
+    table->bucketCount = 1;
+    while (table->bucketCount < uint32_t(_count)) {
+        table->bucketCount *= 2;
+    }
+
+    auto buckets = static_cast<Handle<Entry>*>(
+        arena.alloc(sizeof(Handle<Entry>) * table->bucketCount)
+    );
+
+    for (uint32_t i = 0; i < table->bucketCount; i++) {
+        buckets[i] = Handle<Entry>::null();
+    }
+
+    table->buckets = buckets;
+    table->first = nullptr;
+
+    for (int i = 0; i < _count; i++) {
+        auto entry = static_cast<Entry*>(arena.alloc(sizeof(Entry)));
+        entry->key = uint64_t(i) * 7919;
+        entry->value = makeValue(entry->key);
+
+        auto& bucket = buckets[entry->key & (table->bucketCount - 1)];
+        entry->next = bucket;
+        bucket = arena.toHandle(entry);
+
+        if (table->first == nullptr) {
+            table->first = entry;
+        }
+    }
+
+    arena.setRoot(table);
+    arena.addRelocation(reinterpret_cast<void**>(&table->first));
+    return table;
+}
+
+uint64_t lookupAll(Arena& arena)
+{
+    auto table = static_cast<Table*>(arena.getRoot());
+    auto buckets = table->buckets.get();
+
+    uint64_t result = 0;
+    for (int i = 0; i < _count; i++) {
+        uint64_t key = uint64_t(i) * 7919;
+        auto entry = arena.get(buckets[key & (table->bucketCount - 1)]);
+        while (entry && entry->key != key) {
+            entry = arena.get(entry->next);
+        }
+
+        if (entry == nullptr || entry->value != makeValue(key)) {
+            RAISE(RuntimeException, "Invalid lookup result");
+        }
+
+        result += entry->value;
+    }
+
+    if (table->first == nullptr || table->first->key != 0) {
+        RAISE(RuntimeException, "Invalid relocated pointer");
+    }
+
+    return result;
+}
+
+// Вытесняет образ из page cache, чтобы измерить холодную загрузку.
+void dropCache()
+{
+#ifdef OS_POSIX
+    int file = open(_imagePath, O_RDONLY);
+    if (file != -1) {
+        fdatasync(file);
+        posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+        close(file);
+    }
+#endif
+}
+
+template<class Func>
+void measure(const char* name, Func func)
+{
+    Time startTime = high_resolution_clock::now();
+    func();
+    Time endTime = high_resolution_clock::now();
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+}
+
+TestArena::TestArena()
+{
+
+}
+
+void TestArena::run()
+{
+    imageTest();
+    damagedImageTest();
+    loadSpeedTest();
+    remove(_imagePath);
+}
+
+void TestArena::imageTest()
+{
+    Arena arena;
+    buildTable(arena);
+    uint64_t expected = lookupAll(arena);
+    arena.save(_imagePath);
+
+    // исходная арена еще занимает свой адрес, образ будет перемещен
+    Arena loaded(_imagePath);
+    if (!loaded.isRelocated() || lookupAll(loaded) != expected) {
+        RAISE(RuntimeException, "Invalid relocated image");
+    }
+
+    // в загруженную арену можно продолжать выделять
+    loaded.alloc(1024);
+}
+
+void TestArena::damagedImageTest()
+{
+    // исходная арена занимает свой адрес, поэтому образ перемещается и
+    // цепочка исправлений читается из файла
+    Arena arena;
+    for (int i = 0; i < 1000; i++) {
+        auto slot = static_cast<void**>(arena.alloc(sizeof(void*)));
+        *slot = arena.alloc(64);
+        arena.addRelocation(slot);
+    }
+    arena.save(_imagePath);
+
+    std::vector<char> image;
+    FILE* file = fopen(_imagePath, "rb");
+    int c;
+    while ((c = fgetc(file)) != EOF) {
+        image.push_back(char(c));
+    }
+    fclose(file);
+
+    auto write = [](const std::vector<char>& data, size_t size) {
+        FILE* file = fopen(_imagePath, "wb");
+        fwrite(data.data(), 1, size, file);
+        fclose(file);
+    };
+
+    auto rejected = [] {
+        try {
+            Arena arena(_imagePath);
+        } catch (RuntimeException&) {
+            return true;
+        }
+        return false;
+    };
+
+    // обрезанный образ
+    write(image, image.size() / 2);
+    bool truncated = rejected();
+
+    // usedSize больше reservedSize: смещения полей как в заголовке арены
+    auto damaged = image;
+    uint64_t reservedSize = 4096;
+    memcpy(damaged.data() + 24, &reservedSize, sizeof(reservedSize));
+    write(damaged, damaged.size());
+    bool overrun = rejected();
+
+    // поля заголовка: root по смещению 32, relocations - 36; у записи
+    // исправления next идёт первым, slot - за ним
+    uint32_t head;
+    memcpy(&head, image.data() + 36, sizeof(head));
+    size_t headPos = size_t(head) * ARENA_GRANULE;
+
+    auto damageField = [&](size_t pos, uint32_t value) {
+        auto damaged = image;
+        memcpy(damaged.data() + pos, &value, sizeof(value));
+        write(damaged, damaged.size());
+        return rejected();
+    };
+
+    bool chainOut = damageField(36, uint32_t(image.size() / ARENA_GRANULE));
+    bool slotOut = damageField(headPos + 4, UINT32_MAX);
+    bool cycle = damageField(headPos, head);
+    bool rootOut = damageField(32, UINT32_MAX);
+
+    // неповреждённый образ загружается
+    write(image, image.size());
+    Arena loaded(_imagePath);
+
+    if (!truncated || !overrun || !chainOut || !slotOut || !cycle || !rootOut ||
+        !loaded.isRelocated()) {
+        RAISE(RuntimeException, "Damaged arena image was loaded");
+    }
+}
+
+void TestArena::loadSpeedTest()
+{
+    {
+        Arena arena;
+        buildTable(arena);
+        arena.save(_imagePath);
+    }
+
+    measure("arena rebuild", [] {
+        Arena arena;
+        buildTable(arena);
+        lookupAll(arena);
+    });
+
+    dropCache();
+    measure("arena cold load", [] {
+        Arena arena(_imagePath);
+        lookupAll(arena);
+    });
+
+    measure("arena warm load", [] {
+        Arena arena(_imagePath);
+        lookupAll(arena);
+    });
+}
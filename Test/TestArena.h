@@ -0,0 +1,17 @@
+﻿#ifndef TESTARENA_H
+#define TESTARENA_H
+
+
+class TestArena
+{
+public:
+    TestArena();
+
+    void run();
+private:
+    void imageTest();
+    void damagedImageTest();
+    void loadSpeedTest();
+};
+
+#endif // TESTARENA_H
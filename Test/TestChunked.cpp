@@ -0,0 +1,1472 @@
+﻿#include "TestChunked.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdint.h>
+#include "../Align.h"
+#include "../Exception.h"
+#include "../Collections/Array.h"
+#include "../Collections/Holder.h"
+#include "../Collections/Queue.h"
+#include "../Collections/Stack.h"
+#include "../Collections/Parallel.h"
+#include "../Collections/DlList.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace GreedyContainers;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+namespace {
+
+class AlignedAllocator
+{
+public:
+    void* alloc(size_t size)
+    {
+        return alloc(size, DEFAULT_ALIGN);
+    }
+
+    void* alloc(size_t size, size_t align)
+    {
+        return getAlignedMemory(alignValue(size, align), align);
+    }
+
+    void free(void* ptr)
+    {
+        freeAlignedMemory(ptr);
+    }
+};
+
+// Считает вызовы alloc() и байты, которые контейнер держит сейчас и
+// держал в пике.
+class PeakAllocator
+{
+public:
+    PeakAllocator()
+    {
+        _size = 0;
+        _peak = 0;
+        _allocCount = 0;
+    }
+
+    void* alloc(size_t size)
+    {
+        return alloc(size, DEFAULT_ALIGN);
+    }
+
+    void* alloc(size_t size, size_t align)
+    {
+        // размер и смещение хранятся перед блоком, смещение сохраняет
+        // выравнивание
+        auto header = alignValue(sizeof(size_t) * 2, align);
+        auto result = reinterpret_cast<uint8_t*>(
+            getAlignedMemory(alignValue(header + size, align), align)
+        ) + header;
+        reinterpret_cast<size_t*>(result)[-1] = size;
+        reinterpret_cast<size_t*>(result)[-2] = header;
+
+        _size += size;
+        _peak = std::max(_peak, _size);
+        _allocCount++;
+        return result;
+    }
+
+    void free(void* ptr)
+    {
+        auto sizes = reinterpret_cast<size_t*>(ptr);
+        _size -= sizes[-1];
+        freeAlignedMemory(reinterpret_cast<uint8_t*>(ptr) - sizes[-2]);
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    size_t peak() const
+    {
+        return _peak;
+    }
+
+    size_t allocCount() const
+    {
+        return _allocCount;
+    }
+private:
+    size_t _size;
+    size_t _peak;
+    size_t _allocCount;
+};
+
+// Тип, которому нужно больше, чем выравнивание по умолчанию.
+struct alignas(32) Vector8
+{
+    Vector8(float value)
+    {
+        for (int i = 0; i < 8; i++) {
+            data[i] = value;
+        }
+    }
+
+    float data[8];
+};
+
+struct Counter
+{
+    Counter()
+    {
+        value.store(0);
+    }
+
+    std::atomic<int64_t> value;
+};
+
+// Запись из нескольких полей, суммируются все поля.
+struct Particle
+{
+    Particle(int value)
+    {
+        x = value;
+        y = -value;
+        mass = 1;
+    }
+
+    int x;
+    int y;
+    int mass;
+};
+
+// Как Particle, но с нетривиальным деструктором: очистка обходит элементы.
+struct Tracked
+{
+    Tracked(int value)
+    {
+        x = value;
+    }
+
+    ~Tracked()
+    {
+        x = -1;
+    }
+
+    int x;
+};
+
+// Считает живые объекты, чтобы проверить, что каждый разрушен один раз.
+struct Counted
+{
+    Counted(int value)
+    {
+        x = value;
+        live++;
+    }
+
+    Counted(const Counted& other)
+    {
+        x = other.x;
+        live++;
+    }
+
+    ~Counted()
+    {
+        live--;
+    }
+
+    int x;
+    static int live;
+};
+
+int Counted::live = 0;
+
+// Элемент размером Size байт.
+template<size_t Size>
+struct Blob
+{
+    Blob(int value)
+    {
+        data[0] = value;
+    }
+
+    int data[Size / sizeof(int)];
+};
+
+static const int _threadCount = 4;
+static int _count = 10000000;
+
+// Каждый поток увеличивает свой счётчик, счётчики лежат в одном ObjHolder.
+template<class Holder>
+void countThreads(const char* name)
+{
+    AlignedAllocator allocator;
+    Holder holder(allocator, 1);
+
+    Counter* counters[_threadCount];
+    for (int i = 0; i < _threadCount; i++) {
+        counters[i] = holder.add();
+    }
+
+    Time startTime = high_resolution_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < _threadCount; i++) {
+        auto counter = counters[i];
+        threads.emplace_back([counter]() {
+            for (int j = 0; j < _count; j++) {
+                counter->value.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    Time endTime = high_resolution_clock::now();
+
+    for (int i = 0; i < _threadCount; i++) {
+        if (counters[i]->value.load() != _count) {
+            RAISE(RuntimeException, "Invalid counter value");
+        }
+    }
+
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+void printTime(const char* container, size_t size, size_t chunkSize, const char* operation,
+               high_resolution_clock::duration time)
+{
+    cout << container << " " << size << "B x" << chunkSize << " " << operation << " ellapsed: "
+         << duration_cast<milliseconds>(time).count() << endl;
+}
+
+// Добавление, обход и удаление одинакового объёма данных: 8 Мб за проход,
+// проходы повторяются на тех же пачках.
+template<size_t Size, size_t ChunkSize>
+void measureChunkSize()
+{
+    using Item = Blob<Size>;
+    const int count = 8 * 1024 * 1024 / Size;
+    const int passCount = 8;
+    const size_t chunkSize = Internal::chunkSizeFor<Item>(ChunkSize);
+    AlignedAllocator allocator;
+
+    {
+        ObjStack<Item, AlignedAllocator, ChunkSize> stack(allocator, 1);
+        high_resolution_clock::duration pushTime(0);
+        high_resolution_clock::duration iterateTime(0);
+        high_resolution_clock::duration popTime(0);
+
+        for (int pass = 0; pass < passCount; pass++) {
+            Time startTime = high_resolution_clock::now();
+            for (int i = 0; i < count; i++) {
+                stack.push(i);
+            }
+            Time endTime = high_resolution_clock::now();
+            pushTime += endTime - startTime;
+
+            startTime = high_resolution_clock::now();
+            int64_t sum = 0;
+            for (auto& item : stack) {
+                sum += item.data[0];
+            }
+            endTime = high_resolution_clock::now();
+            iterateTime += endTime - startTime;
+
+            if (sum != int64_t(count - 1) * count / 2) {
+                RAISE(RuntimeException, "Invalid stack sum");
+            }
+
+            startTime = high_resolution_clock::now();
+            while (!stack.isEmpty()) {
+                stack.pop();
+            }
+            endTime = high_resolution_clock::now();
+            popTime += endTime - startTime;
+        }
+
+        printTime("ObjStack", Size, chunkSize, "push", pushTime);
+        printTime("ObjStack", Size, chunkSize, "iterate", iterateTime);
+        printTime("ObjStack", Size, chunkSize, "pop", popTime);
+    }
+
+    {
+        ObjQueue<Item, AlignedAllocator, ChunkSize> queue(allocator, 1);
+
+        Time startTime = high_resolution_clock::now();
+        for (int pass = 0; pass < passCount; pass++) {
+            for (int i = 0; i < count; i++) {
+                queue.enqueue(i);
+            }
+            while (!queue.isEmpty()) {
+                queue.dequeue();
+            }
+        }
+        Time endTime = high_resolution_clock::now();
+        printTime("ObjQueue", Size, chunkSize, "enqueue/dequeue", endTime - startTime);
+    }
+}
+
+using CountedQueue = ObjQueue<Counted, PeakAllocator, 4>;
+
+// Контейнер, возвращаемый из фабрики: голова очереди не в начале пачки.
+CountedQueue makeQueue(PeakAllocator& allocator, int first, int count)
+{
+    CountedQueue queue(allocator, 1);
+    for (int i = first - 3; i < first + count; i++) {
+        queue.enqueue(i);
+    }
+    for (int i = 0; i < 3; i++) {
+        queue.dequeue();
+    }
+
+    return queue;
+}
+
+template<class Container>
+void checkItems(Container& container, int first, int count)
+{
+    int expected = first;
+    for (auto& item : container) {
+        if (item.x != expected++) {
+            RAISE(RuntimeException, "Invalid moved item");
+        }
+    }
+
+    if (container.count() != count || expected != first + count) {
+        RAISE(RuntimeException, "Invalid moved count");
+    }
+}
+
+// Очередь в установившемся режиме: волны по count элементов, на каждые два
+// enqueue() один dequeue(), затем очередь опустошается.
+void measureQueue(const char* name, size_t maxReserve, bool autoTrim)
+{
+    const int count = 200000;
+    const int waveCount = 50;
+    PeakAllocator allocator;
+    size_t afterDrain = 0;
+
+    Time startTime = high_resolution_clock::now();
+    {
+        ObjQueue<Particle, PeakAllocator> queue(allocator, 1);
+        queue.setMaxReserve(maxReserve);
+        queue.setAutoTrim(autoTrim);
+
+        int expected = 0;
+        for (int wave = 0; wave < waveCount; wave++) {
+            for (int i = 0; i < count; i++) {
+                queue.enqueue(i);
+                if (i % 2) {
+                    if (queue.peek()->x != expected++) {
+                        RAISE(RuntimeException, "Invalid queue order");
+                    }
+                    queue.dequeue();
+                }
+            }
+
+            while (!queue.isEmpty()) {
+                if (queue.peek()->x != expected++) {
+                    RAISE(RuntimeException, "Invalid queue order");
+                }
+                queue.dequeue();
+            }
+
+            expected = 0;
+        }
+
+        afterDrain = allocator.size();
+    }
+    Time endTime = high_resolution_clock::now();
+
+    if (allocator.size() != 0) {
+        RAISE(RuntimeException, "Queue chunks leaked");
+    }
+
+    cout << "ObjQueue " << name << " ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count()
+         << ", allocs: " << allocator.allocCount()
+         << ", peak KB: " << allocator.peak() / 1024
+         << ", after drain KB: " << afterDrain / 1024 << endl;
+}
+
+}
+
+TestChunked::TestChunked()
+{
+
+}
+
+void TestChunked::run()
+{
+    alignTest();
+    falseSharingTest();
+    iterateTest();
+    parallelTest();
+    chunkSizeTest();
+    queueTest();
+    bulkTest();
+    batchTest();
+    moveTest();
+    viewTest();
+    tryTest();
+    removeTest();
+}
+
+void TestChunked::alignTest()
+{
+    AlignedAllocator allocator;
+
+    {
+        ObjQueue<Vector8, AlignedAllocator, 3> queue(allocator, 1);
+        for (int i = 0; i < 10; i++) {
+            if (!checkAlign(queue.enqueue(float(i)), alignof(Vector8))) {
+                RAISE(RuntimeException, "Misaligned queue item");
+            }
+        }
+    }
+
+    {
+        DlObjList<Vector8, AlignedAllocator> list(allocator, 3, 3);
+        for (int i = 0; i < 10; i++) {
+            list.addLast(float(i));
+        }
+
+        for (auto& value : list) {
+            if (!checkAlign(&value, alignof(Vector8))) {
+                RAISE(RuntimeException, "Misaligned list item");
+            }
+        }
+    }
+
+    {
+        ObjHolder<Counter, AlignedAllocator, 4, CACHE_LINE_SIZE> holder(allocator, 1);
+        auto first = holder.add();
+        auto second = holder.add();
+        if (!checkAlign(first, CACHE_LINE_SIZE) ||
+            reinterpret_cast<uintptr_t>(second) - reinterpret_cast<uintptr_t>(first) != CACHE_LINE_SIZE) {
+            RAISE(RuntimeException, "Counters share cache line");
+        }
+    }
+}
+
+void TestChunked::falseSharingTest()
+{
+    countThreads<ObjHolder<Counter, AlignedAllocator, 8>>("packed counters");
+    countThreads<ObjHolder<Counter, AlignedAllocator, 8, CACHE_LINE_SIZE>>("cache line counters");
+}
+
+void TestChunked::iterateTest()
+{
+    AlignedAllocator allocator;
+
+    {
+        ObjQueue<Particle, AlignedAllocator, 4> queue(allocator, 1);
+        for (int i = 0; i < 10; i++) {
+            queue.enqueue(i);
+        }
+        queue.dequeue();
+        queue.dequeue();
+
+        int expected = 2;
+        for (auto& particle : queue) {
+            if (particle.x != expected++) {
+                RAISE(RuntimeException, "Invalid queue iteration");
+            }
+        }
+
+        int count = 0;
+        queue.forEachChunk([&](Particle* first, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                if (first[i].x != count + 2) {
+                    RAISE(RuntimeException, "Invalid queue span");
+                }
+                count++;
+            }
+        });
+
+        if (count != 8 || expected != 10) {
+            RAISE(RuntimeException, "Invalid queue iteration count");
+        }
+    }
+
+    {
+        const ObjStack<Particle, AlignedAllocator, 4> stack(allocator, 1);
+        if (stack.begin() != stack.end()) {
+            RAISE(RuntimeException, "Empty stack is not empty");
+        }
+    }
+
+    // набор помещается в кэш, чтобы сравнивались сами циклы, а не
+    // пропускная способность памяти
+    const int size = _count / 100;
+    const int passCount = 500;
+
+    using Holder = ObjHolder<Particle, AlignedAllocator, 256>;
+    Holder holder(allocator, 1);
+    for (int i = 0; i < size; i++) {
+        holder.add(i);
+    }
+
+    // x + y == 0, mass == 1
+    int64_t expected = int64_t(size) * passCount;
+
+    {
+        Time startTime = high_resolution_clock::now();
+        int64_t sum = 0;
+        for (int pass = 0; pass < passCount; pass++) {
+            auto e = holder.getEnumerator();
+            while (e.moveNext()) {
+                auto particle = e.current();
+                sum += particle->x + particle->y + particle->mass;
+            }
+        }
+        Time endTime = high_resolution_clock::now();
+
+        if (sum != expected) {
+            RAISE(RuntimeException, "Invalid enumerator sum");
+        }
+        cout << "ObjHolder enumerator sum ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        Time startTime = high_resolution_clock::now();
+        int64_t sum = 0;
+        for (int pass = 0; pass < passCount; pass++) {
+            for (auto& particle : holder) {
+                sum += particle.x + particle.y + particle.mass;
+            }
+        }
+        Time endTime = high_resolution_clock::now();
+
+        if (sum != expected) {
+            RAISE(RuntimeException, "Invalid iterator sum");
+        }
+        cout << "ObjHolder iterator sum ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        Time startTime = high_resolution_clock::now();
+        int64_t sum = 0;
+        for (int pass = 0; pass < passCount; pass++) {
+            holder.forEachChunk([&](Particle* first, size_t size) {
+                int64_t chunkSum = 0;
+                for (size_t i = 0; i < size; i++) {
+                    chunkSum += first[i].x + first[i].y + first[i].mass;
+                }
+                sum += chunkSum;
+            });
+        }
+        Time endTime = high_resolution_clock::now();
+
+        if (sum != expected) {
+            RAISE(RuntimeException, "Invalid chunk sum");
+        }
+        cout << "ObjHolder forEachChunk sum ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+}
+
+void TestChunked::parallelTest()
+{
+    using Holder = ObjHolder<Particle, AlignedAllocator, 256>;
+    AlignedAllocator allocator;
+    Holder holder(allocator, 1);
+    for (int i = 0; i < _count; i++) {
+        holder.add(i);
+    }
+
+    auto accumulate = [](double acc, const Particle& particle) {
+        return acc + particle.x * 0.001 + particle.mass;
+    };
+    auto combine = [](double a, double b) {
+        return a + b;
+    };
+
+    double expected = 0;
+    size_t threadCounts[] = {1, 2, 4, std::thread::hardware_concurrency()};
+    for (auto threadCount : threadCounts) {
+        ThreadPool pool(threadCount);
+        parallelForEach(pool, holder, [](Particle& particle) { particle.mass = 2; });
+
+        Time startTime = high_resolution_clock::now();
+        auto sum = parallelReduce(pool, holder, 0.0, accumulate, combine);
+        Time endTime = high_resolution_clock::now();
+
+        // части и порядок их объединения не зависят от кол-ва потоков
+        if (threadCount == 1) {
+            expected = sum;
+        } else if (sum != expected) {
+            RAISE(RuntimeException, "Parallel reduce is not deterministic");
+        }
+
+        cout << "parallelReduce " << pool.threadCount() << " threads ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    // исключение из задания доходит до вызывающего потока
+    ThreadPool pool(2);
+    bool raised = false;
+    try {
+        parallelForEach(pool, holder, [](Particle& particle) {
+            if (particle.x == _count / 2) {
+                RAISE(RuntimeException, "Task failed");
+            }
+        });
+    } catch (RuntimeException&) {
+        raised = true;
+    }
+
+    if (!raised) {
+        RAISE(RuntimeException, "Task exception was lost");
+    }
+}
+
+void TestChunked::chunkSizeTest()
+{
+    static_assert(
+        sizeof(Internal::Chunk<Blob<16>, Internal::autoChunkSize<Blob<16>>()>) <= Internal::AUTO_CHUNK_BYTES &&
+        sizeof(Internal::Chunk<Blob<16>, Internal::autoChunkSize<Blob<16>>() + 1>) > Internal::AUTO_CHUNK_BYTES,
+        "Auto chunk must fill AUTO_CHUNK_BYTES"
+    );
+    static_assert(Internal::autoChunkSize<Blob<4096>>() == 1, "Large item needs one slot");
+
+    // то же для пачек узлов, например у Pool
+    using SmallNode = Internal::SlNode<Blob<16>>;
+    static_assert(
+        Internal::nodeChunkSizeFor<SmallNode>(7) == 7 &&
+        Internal::nodeChunkSizeFor<SmallNode>(Internal::AUTO_CHUNK_SIZE) * SmallNode::getDataSize() <
+            Internal::AUTO_CHUNK_BYTES &&
+        Internal::nodeChunkSizeFor<Internal::SlNode<Blob<4096>>>(Internal::AUTO_CHUNK_SIZE) ==
+            Internal::MIN_CHUNK_SIZE,
+        "Invalid node chunk size"
+    );
+
+    // прежний размер по умолчанию и автоматический
+    measureChunkSize<4, 5>();
+    measureChunkSize<4, Internal::AUTO_CHUNK_SIZE>();
+    measureChunkSize<16, 5>();
+    measureChunkSize<16, Internal::AUTO_CHUNK_SIZE>();
+    measureChunkSize<64, 5>();
+    measureChunkSize<64, Internal::AUTO_CHUNK_SIZE>();
+    measureChunkSize<256, 5>();
+    measureChunkSize<256, Internal::AUTO_CHUNK_SIZE>();
+}
+
+void TestChunked::queueTest()
+{
+    AlignedAllocator allocator;
+
+    // enqueue() после dequeue() пишет за последним элементом, а не
+    // поверх первого
+    ObjQueue<Particle, AlignedAllocator, 3> queue(allocator, 1);
+    int head = 0;
+    int tail = 0;
+    for (int i = 0; i < 1000; i++) {
+        queue.enqueue(tail++);
+        if (i % 3 == 2) {
+            queue.enqueue(tail++);
+        }
+        if (i % 2) {
+            if (queue.peek()->x != head++) {
+                RAISE(RuntimeException, "Invalid queue order");
+            }
+            queue.dequeue();
+        }
+    }
+
+    for (auto& item : queue) {
+        if (item.x != head++) {
+            RAISE(RuntimeException, "Invalid queue order");
+        }
+    }
+
+    if (head != tail) {
+        RAISE(RuntimeException, "Invalid queue count");
+    }
+
+    // первая чистка возвращает всё, что набрала волна; то, что пришлось
+    // выделить заново, следующие чистки оставляют в пуле
+    {
+        PeakAllocator peakAllocator;
+        ObjQueue<Particle, PeakAllocator> trimmed(peakAllocator, 1);
+        trimmed.setAutoTrim(true);
+
+        size_t allocs[3];
+        size_t afterDrain[3];
+        for (int wave = 0; wave < 3; wave++) {
+            for (int i = 0; i < 10000; i++) {
+                trimmed.enqueue(i);
+            }
+            while (!trimmed.isEmpty()) {
+                trimmed.dequeue();
+            }
+
+            allocs[wave] = peakAllocator.allocCount();
+            afterDrain[wave] = peakAllocator.size();
+        }
+
+        if (afterDrain[0] * 2 > peakAllocator.peak() || allocs[2] != allocs[1]) {
+            RAISE(RuntimeException, "Invalid auto trim reserve");
+        }
+    }
+
+    measureQueue("one chunk at a time", 1, false);
+    measureQueue("geometric", Internal::MAX_CHUNK_RESERVE, false);
+    measureQueue("geometric, auto trim", Internal::MAX_CHUNK_RESERVE, true);
+}
+
+void TestChunked::bulkTest()
+{
+    AlignedAllocator allocator;
+
+    std::vector<Particle> source;
+    for (int i = 0; i < 1000; i++) {
+        source.emplace_back(i);
+    }
+
+    // memcpy по пачкам, в том числе с середины пачки у очереди
+    {
+        ObjQueue<Particle, AlignedAllocator, 7> queue(allocator, 1);
+        for (int i = 0; i < 10; i++) {
+            queue.enqueue(-1);
+        }
+        for (int i = 0; i < 10; i++) {
+            queue.dequeue();
+        }
+
+        queue.appendRange(source.data(), source.data() + source.size());
+        std::vector<Particle> copy(source.size(), Particle(0));
+        if (queue.copyTo(copy.data()) != copy.data() + copy.size()) {
+            RAISE(RuntimeException, "Invalid copy end");
+        }
+
+        for (size_t i = 0; i < copy.size(); i++) {
+            if (copy[i].x != int(i) || queue.peek()->x != int(i)) {
+                RAISE(RuntimeException, "Invalid bulk queue item");
+            }
+            queue.dequeue();
+        }
+    }
+
+    // поэлементно: нетривиальный T, слоты с промежутками; указатели -
+    // memcpy
+    {
+        std::vector<Tracked> tracked;
+        std::vector<Particle*> pointerSource;
+        for (auto& particle : source) {
+            tracked.emplace_back(particle.x);
+            pointerSource.push_back(&particle);
+        }
+
+        ObjStack<Tracked, AlignedAllocator, 5> stack(allocator, 1);
+        stack.appendRange(tracked.begin(), tracked.end());
+        ObjHolder<Particle, AlignedAllocator, 5, 32> aligned(allocator, 1);
+        aligned.appendRange(source.begin(), source.end());
+        PtrHolder<Particle, AlignedAllocator> pointers(allocator, 1);
+        pointers.appendRange(pointerSource.data(), pointerSource.data() + pointerSource.size());
+
+        std::vector<Tracked> trackedCopy;
+        stack.copyTo(std::back_inserter(trackedCopy));
+        std::vector<Particle> alignedCopy;
+        aligned.copyTo(std::back_inserter(alignedCopy));
+        std::vector<Particle*> pointerCopy(pointerSource.size());
+        pointers.copyTo(pointerCopy.begin());
+
+        for (size_t i = 0; i < source.size(); i++) {
+            if (trackedCopy[i].x != int(i) || alignedCopy[i].x != int(i) ||
+                pointerCopy[i] != &source[i]) {
+                RAISE(RuntimeException, "Invalid bulk copy");
+            }
+        }
+    }
+
+    // очистка тривиально разрушаемых элементов не обходит их
+    std::vector<Particle> particles;
+    for (int i = 0; i < _count; i++) {
+        particles.emplace_back(i);
+    }
+
+    {
+        ObjHolder<Particle, AlignedAllocator> holder(allocator, 1);
+
+        Time startTime = high_resolution_clock::now();
+        for (auto& particle : particles) {
+            holder.add(particle);
+        }
+        Time endTime = high_resolution_clock::now();
+        cout << "ObjHolder add ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        holder.clear();
+        startTime = high_resolution_clock::now();
+        holder.appendRange(particles.data(), particles.data() + particles.size());
+        endTime = high_resolution_clock::now();
+        cout << "ObjHolder appendRange ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        std::vector<Particle> copy(particles.size(), Particle(0));
+        startTime = high_resolution_clock::now();
+        holder.copyTo(copy.data());
+        endTime = high_resolution_clock::now();
+        cout << "ObjHolder copyTo ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        if (copy.back().x != _count - 1) {
+            RAISE(RuntimeException, "Invalid bulk copy");
+        }
+
+        startTime = high_resolution_clock::now();
+        holder.clear();
+        endTime = high_resolution_clock::now();
+        cout << "ObjHolder trivial clear ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        ObjHolder<Tracked, AlignedAllocator> holder(allocator, 1);
+        for (int i = 0; i < _count; i++) {
+            holder.add(i);
+        }
+
+        Time startTime = high_resolution_clock::now();
+        holder.clear();
+        Time endTime = high_resolution_clock::now();
+        cout << "ObjHolder non-trivial clear ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+}
+
+void TestChunked::batchTest()
+{
+    AlignedAllocator allocator;
+
+    std::vector<Particle> source;
+    for (int i = 0; i < 1000; i++) {
+        source.emplace_back(i);
+    }
+
+    std::vector<Particle> out(1000, Particle(0));
+
+    {
+        ObjQueue<Particle, AlignedAllocator, 7> queue(allocator, 1);
+        int next = 0;
+        for (int i = 0; i < 1000; i += 13) {
+            queue.enqueueN(source.data() + i, std::min(13, 1000 - i));
+            int count = queue.dequeueN(out.data(), 10);
+            queue.dequeue();
+            for (int j = 0; j < count; j++) {
+                if (out[j].x != next++) {
+                    RAISE(RuntimeException, "Invalid dequeueN order");
+                }
+            }
+            next++;
+        }
+
+        int count = queue.dequeueN(out.data(), 1000);
+        if (count + next != 1000 || out[count - 1].x != 999 || !queue.isEmpty()) {
+            RAISE(RuntimeException, "Invalid dequeueN count");
+        }
+
+        queue.enqueue(5);
+        if (queue.peek()->x != 5) {
+            RAISE(RuntimeException, "Invalid queue after dequeueN");
+        }
+    }
+
+    {
+        ObjStack<Particle, AlignedAllocator, 7> stack(allocator, 1);
+        stack.pushN(source.data(), 1000);
+        for (int top = 1000; top > 0; top -= 98) {
+            int count = stack.popN(out.data(), 98);
+            for (int j = 0; j < count; j++) {
+                if (out[j].x != top - count + j) {
+                    RAISE(RuntimeException, "Invalid popN order");
+                }
+            }
+
+            if (!stack.isEmpty() && stack.peek()->x != top - count - 1) {
+                RAISE(RuntimeException, "Invalid stack after popN");
+            }
+        }
+
+        stack.push(7);
+        if (stack.count() != 1 || stack.peek()->x != 7) {
+            RAISE(RuntimeException, "Invalid stack after popN");
+        }
+    }
+
+    // поэлементно: нетривиальный T и слоты с промежутками
+    {
+        ObjQueue<Tracked, AlignedAllocator, 5> tracked(allocator, 1);
+        ObjStack<Particle, AlignedAllocator, 5, 32> aligned(allocator, 1);
+        for (int i = 0; i < 100; i++) {
+            tracked.enqueue(i);
+            aligned.push(i);
+        }
+
+        std::vector<Tracked> trackedOut(60, Tracked(0));
+        tracked.dequeueN(trackedOut.data(), 60);
+        aligned.popN(out.data(), 60);
+        for (int i = 0; i < 60; i++) {
+            if (trackedOut[i].x != i || out[i].x != 40 + i) {
+                RAISE(RuntimeException, "Invalid batch item");
+            }
+        }
+    }
+
+    {
+        PtrQueue<Particle, AlignedAllocator> queue(allocator, 1);
+        PtrStack<Particle, AlignedAllocator> stack(allocator, 1);
+        for (auto& particle : source) {
+            queue.enqueue(&particle);
+            stack.push(&particle);
+        }
+
+        ArrayBuilder<Particle, AlignedAllocator> queueBuilder(allocator, 600);
+        ArrayBuilder<Particle, AlignedAllocator> stackBuilder(allocator, 600);
+        if (queue.drainTo(queueBuilder) != 600 || stack.drainTo(stackBuilder) != 600) {
+            RAISE(RuntimeException, "Invalid drainTo count");
+        }
+
+        auto queueArray = queueBuilder.toArray();
+        auto stackArray = stackBuilder.toArray();
+        for (int i = 0; i < 600; i++) {
+            if (queueArray[i] != &source[i] || stackArray[i] != &source[400 + i]) {
+                RAISE(RuntimeException, "Invalid drainTo item");
+            }
+        }
+
+        if (queue.peek() != &source[600] || stack.peek() != &source[399]) {
+            RAISE(RuntimeException, "Invalid container after drainTo");
+        }
+    }
+
+    // по одному и пачками по 256
+    const int batchSize = 256;
+    std::vector<Particle> batch(batchSize, Particle(0));
+    for (int i = 0; i < batchSize; i++) {
+        batch[i] = Particle(i);
+    }
+
+    {
+        ObjQueue<Particle, AlignedAllocator> queue(allocator, 1);
+        int64_t sum = 0;
+
+        Time startTime = high_resolution_clock::now();
+        for (int i = 0; i < _count; i += batchSize) {
+            for (int j = 0; j < batchSize; j++) {
+                queue.enqueue(batch[j]);
+            }
+            while (!queue.isEmpty()) {
+                sum += queue.peek()->x;
+                queue.dequeue();
+            }
+        }
+        Time endTime = high_resolution_clock::now();
+        cout << "ObjQueue single ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        std::vector<Particle> received(batchSize, Particle(0));
+        int64_t batchSum = 0;
+        startTime = high_resolution_clock::now();
+        for (int i = 0; i < _count; i += batchSize) {
+            queue.enqueueN(batch.data(), batchSize);
+            int count = queue.dequeueN(received.data(), batchSize);
+            for (int j = 0; j < count; j++) {
+                batchSum += received[j].x;
+            }
+        }
+        endTime = high_resolution_clock::now();
+        cout << "ObjQueue batch " << batchSize << " ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        if (sum != batchSum) {
+            RAISE(RuntimeException, "Invalid batch sum");
+        }
+    }
+
+    {
+        ObjStack<Particle, AlignedAllocator> stack(allocator, 1);
+        int64_t sum = 0;
+
+        Time startTime = high_resolution_clock::now();
+        for (int i = 0; i < _count; i += batchSize) {
+            for (int j = 0; j < batchSize; j++) {
+                stack.push(batch[j]);
+            }
+            while (!stack.isEmpty()) {
+                sum += stack.peek()->x;
+                stack.pop();
+            }
+        }
+        Time endTime = high_resolution_clock::now();
+        cout << "ObjStack single ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        std::vector<Particle> received(batchSize, Particle(0));
+        int64_t batchSum = 0;
+        startTime = high_resolution_clock::now();
+        for (int i = 0; i < _count; i += batchSize) {
+            stack.pushN(batch.data(), batchSize);
+            int count = stack.popN(received.data(), batchSize);
+            for (int j = 0; j < count; j++) {
+                batchSum += received[j].x;
+            }
+        }
+        endTime = high_resolution_clock::now();
+        cout << "ObjStack batch " << batchSize << " ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+        if (sum != batchSum) {
+            RAISE(RuntimeException, "Invalid batch sum");
+        }
+    }
+}
+
+void TestChunked::moveTest()
+{
+    PeakAllocator allocator;
+
+    {
+        auto queue = makeQueue(allocator, 0, 10);
+        checkItems(queue, 0, 10);
+
+        CountedQueue moved(std::move(queue));
+        checkItems(moved, 0, 10);
+        checkItems(queue, 0, 0);
+
+        // перемещённый контейнер пуст, но пригоден к работе
+        queue.enqueue(100);
+        checkItems(queue, 100, 1);
+
+        // прежние элементы разрушаются при присваивании
+        moved = makeQueue(allocator, 20, 5);
+        checkItems(moved, 20, 5);
+        if (Counted::live != 6) {
+            RAISE(RuntimeException, "Invalid live count after move");
+        }
+
+        moved.swap(queue);
+        checkItems(moved, 100, 1);
+        checkItems(queue, 20, 5);
+        queue.enqueue(25);
+        checkItems(queue, 20, 6);
+
+        ObjStack<Counted, PeakAllocator, 4> first(allocator, 1);
+        ObjStack<Counted, PeakAllocator, 4> second(allocator, 1);
+        for (int i = 0; i < 9; i++) {
+            first.push(i);
+        }
+        first.swap(second);
+        second.pop();
+        checkItems(second, 0, 8);
+        checkItems(first, 0, 0);
+    }
+
+    if (Counted::live != 0) {
+        RAISE(RuntimeException, "Moved items leaked");
+    }
+
+    {
+        using Holder = ObjHolder<Counted, PeakAllocator, 4>;
+
+        // holder хранится в векторе, который перемещает его при росте
+        std::vector<Holder> stages;
+        for (int i = 0; i < 3; i++) {
+            stages.emplace_back(allocator, 1);
+        }
+        for (int i = 0; i < 8; i++) {
+            stages[0].add(i);
+        }
+        for (int i = 8; i < 18; i++) {
+            stages[1].add(i);
+        }
+        for (int i = 18; i < 21; i++) {
+            stages[2].add(i);
+        }
+
+        // последняя пачка заполнена: пачки перецепляются вместе с элементами
+        auto firstMoved = &*stages[1].begin();
+        stages[0].stealChunks(stages[1]);
+        checkItems(stages[0], 0, 18);
+        checkItems(stages[1], 0, 0);
+        if (&*(++std::next(stages[0].begin(), 7)) != firstMoved) {
+            RAISE(RuntimeException, "Chunks were copied");
+        }
+
+        // последняя пачка не заполнена: элементы перемещаются по одному
+        stages[0].stealChunks(stages[2]);
+        checkItems(stages[0], 0, 21);
+        checkItems(stages[2], 0, 0);
+
+        stages[1].add(50);
+        stages[1].stealChunks(stages[0]);
+        checkItems(stages[0], 0, 0);
+        if (stages[1].count() != 22 || Counted::live != 22) {
+            RAISE(RuntimeException, "Invalid live count after steal");
+        }
+    }
+
+    if (Counted::live != 0 || allocator.size() != 0) {
+        RAISE(RuntimeException, "Stolen chunks leaked");
+    }
+}
+
+void TestChunked::viewTest()
+{
+    PeakAllocator allocator;
+
+    {
+        ObjQueue<Particle, PeakAllocator, 5> queue(allocator, 1);
+        for (int i = -3; i < 100; i++) {
+            queue.enqueue(i);
+        }
+        for (int i = 0; i < 3; i++) {
+            queue.dequeue();
+        }
+
+        auto before = allocator.size();
+        {
+            auto view = queue.toArray();
+            if (view.count() != 100 || view.chunkCount() != 21) {
+                RAISE(RuntimeException, "Invalid view size");
+            }
+
+            int expected = 0;
+            for (auto& item : view) {
+                if (item.x != expected || view[expected]->x != expected) {
+                    RAISE(RuntimeException, "Invalid view item");
+                }
+                expected++;
+            }
+
+            // пачки не копируются
+            if (view[42] != &*std::next(queue.begin(), 42)) {
+                RAISE(RuntimeException, "View copied items");
+            }
+        }
+
+        // оглавление не берётся у аллокатора контейнера
+        if (allocator.size() != before) {
+            RAISE(RuntimeException, "View used container allocator");
+        }
+
+        // мелкое оглавление не выделяет память
+        ObjHolder<Particle, PeakAllocator, 5> holder(allocator, 1);
+        for (int i = 0; i < 12; i++) {
+            holder.add(i);
+        }
+        auto allocCount = allocator.allocCount();
+        auto view = holder.toArray();
+        int64_t sum = 0;
+        view.forEachChunk([&sum](Particle* first, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                sum += first[i].x;
+            }
+        });
+        if (sum != 66 || view[11]->x != 11 || allocator.allocCount() != allocCount) {
+            RAISE(RuntimeException, "Invalid small view");
+        }
+    }
+
+    // копия указателей в Array против представления
+    using Holder = ObjHolder<Particle, PeakAllocator>;
+    Holder holder(allocator, 1);
+    for (int i = 0; i < 1000000; i++) {
+        holder.add(i);
+    }
+
+    // Array не возвращает память, поэтому проходов немного
+    const int passCount = 10;
+    int64_t copySum = 0;
+    auto before = allocator.size();
+    Time startTime = high_resolution_clock::now();
+    for (int pass = 0; pass < passCount; pass++) {
+        ArrayBuilder<Particle, PeakAllocator> builder(allocator, holder.count());
+        for (auto& item : holder) {
+            builder.add(&item);
+        }
+
+        auto array = builder.toArray();
+        copySum += array[pass * 1000]->x;
+    }
+    Time endTime = high_resolution_clock::now();
+    cout << "ObjHolder Array copy ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count()
+         << ", KB kept: " << (allocator.size() - before) / 1024 << endl;
+
+    int64_t viewSum = 0;
+    before = allocator.size();
+    startTime = high_resolution_clock::now();
+    for (int pass = 0; pass < passCount; pass++) {
+        auto view = holder.toArray();
+        viewSum += view[pass * 1000]->x;
+    }
+    endTime = high_resolution_clock::now();
+    cout << "ObjHolder view ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count()
+         << ", KB kept: " << (allocator.size() - before) / 1024 << endl;
+
+    if (copySum != viewSum) {
+        RAISE(RuntimeException, "Invalid view sum");
+    }
+}
+
+void TestChunked::tryTest()
+{
+    AlignedAllocator allocator;
+
+    {
+        ObjQueue<Tracked, AlignedAllocator, 3> queue(allocator, 1);
+        ObjStack<Tracked, AlignedAllocator, 3> stack(allocator, 1);
+        Tracked out(0);
+        if (queue.tryPeek() || queue.tryDequeue() || queue.tryPopInto(out) ||
+            stack.tryPeek() || stack.tryPop() || stack.tryPopInto(out)) {
+            RAISE(RuntimeException, "Empty container returned item");
+        }
+
+        for (int i = 1; i <= 5; i++) {
+            queue.enqueue(i);
+            stack.push(i);
+        }
+
+        if (queue.tryPeek()->x != 1 || !queue.tryDequeue() || !queue.tryPopInto(out) || out.x != 2) {
+            RAISE(RuntimeException, "Invalid queue try item");
+        }
+        if (stack.tryPeek()->x != 5 || !stack.tryPop() || !stack.tryPopInto(out) || out.x != 4) {
+            RAISE(RuntimeException, "Invalid stack try item");
+        }
+        if (queue.count() != 3 || stack.count() != 3 || queue.peek()->x != 3 || stack.peek()->x != 3) {
+            RAISE(RuntimeException, "Invalid count after try");
+        }
+
+        PtrQueue<Tracked, AlignedAllocator> pointers(allocator, 1);
+        Tracked* pointer = nullptr;
+        pointers.enqueue(&out);
+        if (!pointers.tryPopInto(pointer) || pointer != &out || pointers.tryPopInto(pointer)) {
+            RAISE(RuntimeException, "Invalid pointer try item");
+        }
+    }
+
+    // опрос пустой очереди; через volatile указатель, чтобы компилятор
+    // не вынес проверку из цикла
+    ObjQueue<Particle, AlignedAllocator> queue(allocator, 1);
+    ObjQueue<Particle, AlignedAllocator>* volatile polled = &queue;
+    Particle out(0);
+    int hits = 0;
+
+    Time startTime = high_resolution_clock::now();
+    for (int i = 0; i < _count; i++) {
+        hits += polled->tryPopInto(out);
+    }
+    Time endTime = high_resolution_clock::now();
+    cout << "ObjQueue " << _count << " tryPopInto polls ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    startTime = high_resolution_clock::now();
+    for (int i = 0; i < _count; i++) {
+        if (!polled->isEmpty()) {
+            polled->dequeue();
+            hits++;
+        }
+    }
+    endTime = high_resolution_clock::now();
+    cout << "ObjQueue " << _count << " isEmpty polls ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    // исключение на каждый опрос в сотни раз дороже, поэтому опросов меньше
+    const int throwCount = _count / 100;
+    startTime = high_resolution_clock::now();
+    for (int i = 0; i < throwCount; i++) {
+        try {
+            queue.dequeue();
+            hits++;
+        } catch (RuntimeException&) {
+        }
+    }
+    endTime = high_resolution_clock::now();
+    cout << "ObjQueue " << throwCount << " throwing polls ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    if (hits != 0) {
+        RAISE(RuntimeException, "Empty queue returned item");
+    }
+}
+
+void TestChunked::removeTest()
+{
+    PeakAllocator allocator;
+
+    {
+        ObjHolder<Counted, PeakAllocator, 5, alignof(Counted), true> holder(allocator, 1);
+        std::vector<Counted*> items;
+        for (int i = 0; i < 23; i++) {
+            items.push_back(holder.add(i));
+        }
+
+        // нечётные удаляются, у чётных адреса не меняются
+        for (int i = 1; i < 23; i += 2) {
+            holder.remove(items[i]);
+        }
+
+        int sum = 0;
+        int visited = 0;
+        for (auto& item : holder) {
+            sum += item.x;
+            visited++;
+        }
+        size_t spans = 0;
+        holder.forEachChunk([&](Counted* first, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                spans += first[i].x % 2 == 0;
+            }
+        });
+        if (holder.count() != 12 || visited != 12 || spans != 12 || sum != 132 ||
+            Counted::live != 12 || items[22]->x != 22) {
+            RAISE(RuntimeException, "Invalid holder after remove");
+        }
+
+        // перечислитель и представление тоже пропускают дыры
+        auto view = holder.toArray();
+        auto enumerator = holder.getEnumerator();
+        int expected = 0;
+        while (enumerator.moveNext()) {
+            if (enumerator.current() != items[expected] || view[expected / 2] != items[expected]) {
+                RAISE(RuntimeException, "Invalid holder enumerator after remove");
+            }
+            expected += 2;
+        }
+        spans = 0;
+        view.forEachChunk([&](Counted* first, size_t n) {
+            spans += n;
+        });
+        if (expected != 24 || view.count() != 12 || spans != 12) {
+            RAISE(RuntimeException, "Invalid holder view after remove");
+        }
+
+        // повторное удаление - ошибка
+        try {
+            holder.remove(items[1]);
+            RAISE(RuntimeException, "Invalid holder use accepted");
+        } catch (ArgumentException&) {
+        }
+
+        // новые элементы занимают дыры, память не растёт
+        auto size = allocator.size();
+        for (int i = 0; i < 11; i++) {
+            auto item = holder.add(100 + i);
+            if (std::find(items.begin(), items.end(), item) == items.end()) {
+                RAISE(RuntimeException, "Hole was not reused");
+            }
+        }
+        if (holder.count() != 23 || allocator.size() != size) {
+            RAISE(RuntimeException, "Invalid holder after reuse");
+        }
+
+        // пачка без элементов возвращается пулу
+        for (int i = 5; i < 15; i++) {
+            holder.remove(items[i]);
+        }
+        holder.shrink();
+        if (holder.count() != 13 || allocator.size() >= size) {
+            RAISE(RuntimeException, "Empty chunks were not released");
+        }
+
+        holder.remove(items[0]);
+        holder.remove(items[22]);
+        auto moved = holder.compact();
+        std::vector<Counted> values;
+        values.reserve(11);
+        holder.copyTo(std::back_inserter(values));
+        if (moved == 0 || holder.count() != 11 || holder.toArray().count() != 11 ||
+            values.size() != 11 || Counted::live != 22) {
+            RAISE(RuntimeException, "Invalid holder after compact");
+        }
+
+        PtrHolder<Counted, PeakAllocator, 3, true> pointers(allocator, 1);
+        auto slot = pointers.add(items[2]);
+        pointers.add(items[4]);
+        pointers.remove(slot);
+        if (pointers.count() != 1 || *pointers.begin() != items[4]) {
+            RAISE(RuntimeException, "Invalid pointer holder after remove");
+        }
+    }
+
+    if (Counted::live != 0 || allocator.size() != 0) {
+        RAISE(RuntimeException, "Removed items leaked");
+    }
+
+    // без Removable пачки с явным размером лежат плотно
+    {
+        ObjHolder<Particle, PeakAllocator, 100> dense(allocator, 1);
+        dense.add(0);
+        auto denseSize = allocator.size();
+        ObjHolder<Particle, PeakAllocator, 100, alignof(Particle), true> removable(allocator, 1);
+        removable.add(0);
+        if (denseSize >= allocator.size() - denseSize) {
+            RAISE(RuntimeException, "Holder without remove() uses chunk stride");
+        }
+    }
+
+    // обход с дырами после удаления половины элементов и после compact()
+    using Holder = ObjHolder<Particle, PeakAllocator, Internal::AUTO_CHUNK_SIZE, alignof(Particle), true>;
+    Holder holder(allocator, 1);
+    std::vector<Particle*> items;
+    items.reserve(_count);
+    for (int i = 0; i < _count; i++) {
+        items.push_back(holder.add(i));
+    }
+
+    Time startTime = high_resolution_clock::now();
+    for (int i = 0; i < _count; i += 2) {
+        holder.remove(items[i]);
+    }
+    Time endTime = high_resolution_clock::now();
+    cout << "ObjHolder " << _count / 2 << " remove ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    auto sumAll = [](Holder& h) {
+        int64_t sum = 0;
+        for (auto& item : h) {
+            sum += item.x + item.y + item.mass;
+        }
+        return sum;
+    };
+
+    startTime = high_resolution_clock::now();
+    auto holedSum = sumAll(holder);
+    endTime = high_resolution_clock::now();
+    cout << "ObjHolder half holes iterator sum ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    startTime = high_resolution_clock::now();
+    holder.compact(0.75);
+    endTime = high_resolution_clock::now();
+    cout << "ObjHolder compact ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    startTime = high_resolution_clock::now();
+    auto compactSum = sumAll(holder);
+    endTime = high_resolution_clock::now();
+    cout << "ObjHolder compacted iterator sum ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    auto peak = allocator.peak();
+    startTime = high_resolution_clock::now();
+    for (int i = 0; i < _count / 2; i++) {
+        holder.remove(&*holder.begin());
+        holder.add(i);
+    }
+    endTime = high_resolution_clock::now();
+    cout << "ObjHolder " << _count / 2 << " remove/add ellapsed: "
+         << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    if (holedSum != compactSum || holder.count() != _count / 2 || allocator.peak() != peak) {
+        RAISE(RuntimeException, "Invalid holder after remove/add");
+    }
+}
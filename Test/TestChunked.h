@@ -0,0 +1,26 @@
+﻿#ifndef TESTCHUNKED_H
+#define TESTCHUNKED_H
+
+
+class TestChunked
+{
+public:
+    TestChunked();
+
+    void run();
+private:
+    void alignTest();
+    void falseSharingTest();
+    void iterateTest();
+    void parallelTest();
+    void chunkSizeTest();
+    void queueTest();
+    void bulkTest();
+    void batchTest();
+    void moveTest();
+    void viewTest();
+    void tryTest();
+    void removeTest();
+};
+
+#endif // TESTCHUNKED_H
@@ -0,0 +1,213 @@
+﻿#include "TestConcurrentPool.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "../Align.h"
+#include "../Exception.h"
+#include "../Collections/DlList.h"
+#include "../Collections/ConcurrentPool.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace GreedyContainers;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+namespace {
+
+struct Value
+{
+    int a;
+};
+
+// Элемент, конструктор которого заметно дороже выделения узла.
+struct Payload
+{
+    Payload(int a)
+    {
+        for (int i = 0; i < DATA_SIZE; i++) {
+            data[i] = a + i;
+        }
+    }
+
+    int sum() const
+    {
+        int result = 0;
+        for (int i = 0; i < DATA_SIZE; i++) {
+            result += data[i];
+        }
+        return result;
+    }
+
+    static const int DATA_SIZE = 32;
+    int data[DATA_SIZE];
+};
+
+class AlignedAllocator
+{
+public:
+    void* alloc(size_t size)
+    {
+        return alloc(size, DEFAULT_ALIGN);
+    }
+
+    void* alloc(size_t size, size_t align)
+    {
+        return getAlignedMemory(alignValue(size, align), align);
+    }
+
+    void free(void* ptr)
+    {
+        freeAlignedMemory(ptr);
+    }
+};
+
+// кол-во элементов, которые производитель передаёт потребителю
+static int _count = 1000000;
+
+// Производитель создаёт элементы, потребитель читает и уничтожает их,
+// список защищён мьютексом. Если OutsideLock, узлы создаются и
+// уничтожаются вне блокировки - это допустимо только с ConcurrentNodePool.
+template<template<class, class> class Pool, bool OutsideLock>
+void churn(const char* name)
+{
+    using List = DlObjList<Payload, AlignedAllocator, Pool>;
+
+    AlignedAllocator allocator;
+    List list(allocator, 64, 0);
+    std::mutex lock;
+
+    int64_t sum = 0;
+    Time startTime = high_resolution_clock::now();
+
+    std::thread producer([&]() {
+        for (int i = 0; i < _count; i++) {
+            if (OutsideLock) {
+                auto node = list.make(i);
+                std::lock_guard<std::mutex> guard(lock);
+                list.attachLast(std::move(node));
+            } else {
+                std::lock_guard<std::mutex> guard(lock);
+                list.attachLast(list.make(i));
+            }
+        }
+    });
+
+    std::thread consumer([&]() {
+        int consumed = 0;
+        while (consumed < _count) {
+            std::unique_lock<std::mutex> guard(lock);
+            if (list.count() == 0) {
+                guard.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+
+            auto node = list.detachFirst();
+            if (OutsideLock) {
+                guard.unlock();
+            }
+
+            sum += node->sum();
+            consumed++;
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    Time endTime = high_resolution_clock::now();
+
+    int64_t expected = int64_t(_count - 1) * _count / 2 * Payload::DATA_SIZE
+                     + int64_t(Payload::DATA_SIZE - 1) * Payload::DATA_SIZE / 2 * _count;
+    if (sum != expected || list.count() != 0) {
+        RAISE(RuntimeException, "Invalid churn result");
+    }
+
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+}
+
+TestConcurrentPool::TestConcurrentPool()
+{
+
+}
+
+void TestConcurrentPool::run()
+{
+    remoteFreeTest();
+    threadExitTest();
+    churnTest();
+}
+
+void TestConcurrentPool::remoteFreeTest()
+{
+    using NodeType = Internal::DlNode<Value*>;
+    using Pool = Internal::ConcurrentNodePool<NodeType, AlignedAllocator>;
+
+    AlignedAllocator allocator;
+    Pool pool(allocator, 16, 0);
+    Value value = {1};
+
+    std::vector<NodeType*> nodes;
+    for (int i = 0; i < 100; i++) {
+        nodes.push_back(pool.create(&value));
+    }
+
+    // узлы освобождает чужой поток, они должны вернуться в кэш владельца
+    std::thread other([&]() {
+        for (auto node : nodes) {
+            pool.release(node);
+        }
+    });
+    other.join();
+
+    for (int i = 0; i < 100; i++) {
+        auto node = pool.create(&value);
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
+            RAISE(RuntimeException, "Remote node was not reused");
+        }
+    }
+}
+
+void TestConcurrentPool::threadExitTest()
+{
+    using NodeType = Internal::DlNode<Value*>;
+    using Pool = Internal::ConcurrentNodePool<NodeType, AlignedAllocator>;
+
+    AlignedAllocator allocator;
+    Pool pool(allocator, 16, 0);
+    Value value = {1};
+
+    // поток завершается без detachThread(), его кэш открепляется сам
+    std::vector<NodeType*> nodes;
+    std::thread first([&]() {
+        for (int i = 0; i < 100; i++) {
+            nodes.push_back(pool.create(&value));
+        }
+        for (auto node : nodes) {
+            pool.release(node);
+        }
+    });
+    first.join();
+
+    // id завершённого потока может достаться новому потоку, поэтому кэш
+    // забирает поток, у которого id заведомо другой
+    for (int i = 0; i < 100; i++) {
+        auto node = pool.create(&value);
+        if (std::find(nodes.begin(), nodes.end(), node) == nodes.end()) {
+            RAISE(RuntimeException, "Cache of finished thread was not reused");
+        }
+    }
+}
+
+void TestConcurrentPool::churnTest()
+{
+    churn<Internal::NodePool, false>("NodePool churn");
+    churn<Internal::ConcurrentNodePool, true>("ConcurrentNodePool churn");
+}
@@ -0,0 +1,17 @@
+﻿#ifndef TESTCONCURRENTPOOL_H
+#define TESTCONCURRENTPOOL_H
+
+
+class TestConcurrentPool
+{
+public:
+    TestConcurrentPool();
+
+    void run();
+private:
+    void remoteFreeTest();
+    void threadExitTest();
+    void churnTest();
+};
+
+#endif // TESTCONCURRENTPOOL_H
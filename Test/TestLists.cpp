@@ -0,0 +1,810 @@
+﻿#include "TestLists.h"
+
+#include <iostream>
+#include <chrono>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <numeric>
+#include <algorithm>
+#include "../Arena.h"
+#include "../Exception.h"
+#include "../Collections/SlList.h"
+#include "../Collections/DlList.h"
+#include "../Collections/CompactList.h"
+#include "../Collections/Intrusive.h"
+#include "../Collections/Queue.h"
+
+using namespace std;
+using namespace std::chrono;
+using namespace GreedyContainers;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+namespace {
+
+struct Value
+{
+    Value(int a)
+    {
+        this->a = a;
+        this->b = a;
+    }
+
+    int a;
+    int b;
+};
+
+// Считает созданные объекты: перенос между списками не должен их создавать.
+struct Task
+{
+    Task(int priority)
+    {
+        this->priority = priority;
+        created++;
+    }
+
+    int priority;
+
+    static int created;
+};
+
+int Task::created = 0;
+
+// Элемент со встроенными связями для интрузивных списков.
+struct HookedValue : DlHook
+{
+    HookedValue()
+    {
+        a = 0;
+    }
+
+    int a;
+    SlHook slHook;
+};
+
+// Считает байты, запрошенные контейнером.
+class CountingAllocator
+{
+public:
+    CountingAllocator()
+    {
+        _size = 0;
+    }
+
+    void* alloc(size_t size)
+    {
+        _size += size;
+        return malloc(size);
+    }
+
+    void* alloc(size_t size, size_t)
+    {
+        return alloc(size);
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+private:
+    size_t _size;
+};
+
+// Считает байты, которые контейнер держит в данный момент.
+class FreeingAllocator
+{
+public:
+    FreeingAllocator()
+    {
+        _size = 0;
+    }
+
+    void* alloc(size_t size)
+    {
+        auto result = reinterpret_cast<size_t*>(malloc(size + sizeof(size_t) * 2));
+        *result = size;
+        _size += size;
+        return result + 2;
+    }
+
+    void* alloc(size_t size, size_t)
+    {
+        return alloc(size);
+    }
+
+    void free(void* ptr)
+    {
+        auto block = reinterpret_cast<size_t*>(ptr) - 2;
+        _size -= *block;
+        ::free(block);
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+private:
+    size_t _size;
+};
+
+static int _count = 1000000;
+static int _passCount = 10;
+
+// Обход списка объектов даёт ссылки, списка указателей - указатели.
+template<class T>
+const T& toValue(const T& value)
+{
+    return value;
+}
+
+template<class T>
+const T& toValue(T* value)
+{
+    return *value;
+}
+
+template<class List>
+int64_t traverse(List& list)
+{
+    int64_t result = 0;
+    for (int i = 0; i < _passCount; i++) {
+        for (auto& value : list) {
+            result += toValue(value).a;
+        }
+    }
+
+    return result;
+}
+
+template<class List>
+void measureTraverse(const char* name, List& list, int64_t expected)
+{
+    Time startTime = high_resolution_clock::now();
+    auto result = traverse(list);
+    Time endTime = high_resolution_clock::now();
+
+    if (result != expected) {
+        RAISE(RuntimeException, "Invalid traverse result");
+    }
+
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+void printBytes(const char* name, size_t size)
+{
+    cout << name << " bytes per element: " << double(size) / _count << endl;
+}
+
+// Псевдослучайные ключи, одинаковые при каждом запуске.
+int nextKey(uint32_t& seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return int((seed >> 8) % 100000);
+}
+
+// В b - порядок добавления, по нему проверяется устойчивость сортировки.
+template<class List>
+void fillRandom(List& list, int size)
+{
+    uint32_t seed = 1;
+    for (int i = 0; i < size; i++) {
+        list.addLast(nextKey(seed))->b = i;
+    }
+}
+
+template<class List>
+void checkSorted(List& list, int size)
+{
+    int count = 0;
+    Value prev(-1);
+    for (auto& value : list) {
+        if (value.a < prev.a || (value.a == prev.a && value.b < prev.b)) {
+            RAISE(RuntimeException, "Invalid sort order");
+        }
+
+        prev = value;
+        count++;
+    }
+
+    if (count != size) {
+        RAISE(RuntimeException, "Invalid sort result");
+    }
+}
+
+// Прежний способ: значения копируются в вектор, сортируются, и список
+// заполняется заново.
+template<class List>
+void rebuildSort(List& list)
+{
+    std::vector<Value> values;
+    values.reserve(list.count());
+    for (auto& value : list) {
+        values.push_back(value);
+    }
+
+    std::stable_sort(values.begin(), values.end(), [](const Value& a, const Value& b) {
+        return a.a < b.a;
+    });
+
+    list.clear();
+    for (auto& value : values) {
+        list.addLast(value);
+    }
+}
+
+template<class List>
+void measureSort(const char* name, int size)
+{
+    CountingAllocator allocator;
+
+    {
+        List list(allocator, 64, 0);
+        fillRandom(list, size);
+
+        Time startTime = high_resolution_clock::now();
+        list.sort([](Value* a, Value* b) { return a->a < b->a; });
+        Time endTime = high_resolution_clock::now();
+
+        checkSorted(list, size);
+        cout << name << " sort " << size << " ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        List list(allocator, 64, 0);
+        fillRandom(list, size);
+
+        Time startTime = high_resolution_clock::now();
+        rebuildSort(list);
+        Time endTime = high_resolution_clock::now();
+
+        checkSorted(list, size);
+        cout << name << " rebuild sort " << size << " ellapsed: "
+             << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+}
+
+// Память на один маленький контейнер: сам объект и всё, что он выделил,
+// пока пуст и после добавления одного элемента. Пустой ничего не выделяет.
+template<class List, class Add, class ...Args>
+void measureTiny(const char* name, CountingAllocator& allocator, Add add, Args&&... args)
+{
+    const int count = _count / 10;
+
+    std::deque<List> lists;
+    size_t start = allocator.size();
+    for (int i = 0; i < count; i++) {
+        lists.emplace_back(args...);
+    }
+
+    size_t empty = allocator.size() - start;
+    for (auto& list : lists) {
+        add(list);
+    }
+
+    size_t single = allocator.size() - start;
+    cout << name << " bytes per empty: " << sizeof(List) + double(empty) / count << endl;
+    cout << name << " bytes per one-element: " << sizeof(List) + double(single) / count << endl;
+
+    if (empty != 0) {
+        RAISE(RuntimeException, "Empty container allocated memory");
+    }
+}
+
+}
+
+TestLists::TestLists()
+{
+
+}
+
+void TestLists::run()
+{
+    compactTest();
+    shrinkTest();
+    intrusiveTest();
+    spliceTest();
+    tinyTest();
+    sortTest();
+    iteratorTest();
+}
+
+void TestLists::compactTest()
+{
+    int64_t expected = int64_t(_count - 1) * _count / 2 * _passCount;
+
+    {
+        CountingAllocator allocator;
+        DlObjList<Value, CountingAllocator> list(allocator, 50, 50);
+        Time startTime = high_resolution_clock::now();
+        for (int i = 0; i < _count; i++) {
+            list.addLast(i);
+        }
+        Time endTime = high_resolution_clock::now();
+
+        cout << "DlObjList fill ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+        printBytes("DlObjList", allocator.size());
+        measureTraverse("DlObjList traverse", list, expected);
+    }
+
+    // копия разделила бы узлы арены, и оба деструктора вернули бы их в пул
+    static_assert(
+        !std::is_copy_constructible<CompactDlList<Value>>::value &&
+        !std::is_copy_assignable<CompactDlList<Value>>::value &&
+        !std::is_copy_constructible<CompactSlList<Value>>::value &&
+        !std::is_copy_assignable<CompactSlList<Value>>::value,
+        "Compact lists must not be copyable"
+    );
+
+    {
+        Arena arena;
+        size_t start = arena.usedSize();
+
+        CompactDlList<Value> list(arena);
+        for (int i = 0; i < _count; i++) {
+            list.addLast(i);
+        }
+
+        printBytes("CompactDlList", arena.usedSize() - start);
+        measureTraverse("CompactDlList traverse", list, expected);
+
+        // удаление и вставка по handle
+        auto first = list.addFirst(-1);
+        auto second = list.insertAfter(first, 1);
+        list.remove(first);
+        list.insertBefore(second, 0);
+        list.remove(second);
+        list.remove(list.addLast(7));
+        if (list.count() != size_t(_count) + 1 || list.get(list.addFirst(5))->a != 5) {
+            RAISE(RuntimeException, "Invalid CompactDlList state");
+        }
+    }
+
+    {
+        CountingAllocator allocator;
+        SlObjList<Value, CountingAllocator> list(allocator, 50, 50);
+        for (int i = 0; i < _count; i++) {
+            list.addLast(i);
+        }
+
+        printBytes("SlObjList", allocator.size());
+        measureTraverse("SlObjList traverse", list, expected);
+    }
+
+    {
+        Arena arena;
+        size_t start = arena.usedSize();
+
+        CompactSlList<Value> list(arena);
+        for (int i = 0; i < _count; i++) {
+            list.addLast(i);
+        }
+
+        printBytes("CompactSlList", arena.usedSize() - start);
+        measureTraverse("CompactSlList traverse", list, expected);
+
+        auto first = list.addFirst(-1);
+        list.insertAfter(first, 1);
+        list.remove(first);
+        if (list.count() != size_t(_count) + 1) {
+            RAISE(RuntimeException, "Invalid CompactSlList state");
+        }
+    }
+}
+
+void TestLists::shrinkTest()
+{
+    using List = DlObjList<Value, FreeingAllocator>;
+
+    {
+        FreeingAllocator allocator;
+        List list(allocator, 50, 50);
+        std::vector<List::Item> items;
+        items.reserve(_count);
+        for (int i = 0; i < _count; i++) {
+            items.push_back(list.addLast(i));
+        }
+
+        size_t peak = allocator.size();
+
+        // пик прошёл, остаётся 1%
+        for (int i = 0; i < _count - _count / 100; i++) {
+            list.remove(items[i]);
+        }
+
+        Time startTime = high_resolution_clock::now();
+        list.shrink();
+        Time endTime = high_resolution_clock::now();
+
+        cout << "DlObjList shrink ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+        cout << "DlObjList bytes after drain: " << peak << " -> " << allocator.size() << endl;
+
+        if (allocator.size() * 50 > peak || list.count() != size_t(_count / 100)) {
+            RAISE(RuntimeException, "Pool was not shrunk");
+        }
+
+        // освобождённые пачки снова берутся у аллокатора
+        for (int i = 0; i < _count / 100; i++) {
+            list.addFirst(i);
+        }
+    }
+
+    {
+        FreeingAllocator allocator;
+        List list(allocator, 50, 50);
+        list.setAutoTrim(true);
+        std::vector<List::Item> items;
+        items.reserve(_count);
+        for (int i = 0; i < _count; i++) {
+            items.push_back(list.addLast(i));
+        }
+
+        size_t peak = allocator.size();
+        for (int i = 0; i < _count - 10; i++) {
+            list.remove(items[i]);
+        }
+
+        if (allocator.size() * 50 > peak) {
+            RAISE(RuntimeException, "Pool was not trimmed automatically");
+        }
+    }
+
+    {
+        // каждый второй узел занят: пачки вернуть нельзя
+        using Pool = Internal::NodePool<Internal::DlNode<Value>, FreeingAllocator>;
+        FreeingAllocator allocator;
+        Pool pool(allocator, 10, 0);
+        std::vector<Internal::DlNode<Value>*> nodes;
+        for (int i = 0; i < 1000; i++) {
+            nodes.push_back(pool.create(i));
+        }
+        for (size_t i = 0; i < nodes.size(); i += 2) {
+            pool.release(nodes[i]);
+        }
+
+        auto stats = pool.getStats();
+        if (stats.liveCount != 500 || stats.emptyChunkCount != 0 ||
+            stats.fragmentation() < 0.49 || pool.shrink() != 0) {
+            RAISE(RuntimeException, "Invalid NodePool stats");
+        }
+
+        for (size_t i = 1; i < nodes.size(); i += 2) {
+            pool.release(nodes[i]);
+        }
+        stats = pool.getStats();
+        if (stats.emptyChunkCount != stats.chunkCount || pool.shrink() != stats.chunkCount ||
+            allocator.size() != 0) {
+            RAISE(RuntimeException, "Invalid NodePool shrink");
+        }
+
+        pool.release(pool.create(1));
+        if (pool.getStats().nodeCount != 10) {
+            RAISE(RuntimeException, "Invalid NodePool growth");
+        }
+    }
+
+#ifdef DEBUG
+    // повторное освобождение узла односвязного списка замечается в Debug
+    {
+        using Pool = Internal::NodePool<Internal::SlNode<Value>, FreeingAllocator>;
+        FreeingAllocator allocator;
+        Pool pool(allocator, 10, 0);
+        auto node = pool.create(1);
+        pool.release(node);
+
+        bool detected = false;
+        try {
+            pool.release(node);
+        } catch (Exception&) {
+            detected = true;
+        }
+
+        if (!detected || pool.getStats().liveCount != 0) {
+            RAISE(RuntimeException, "Double release of SlNode was not detected");
+        }
+    }
+#endif
+}
+
+void TestLists::intrusiveTest()
+{
+    int64_t expected = int64_t(_count - 1) * _count / 2 * _passCount;
+
+    // объекты уже где-то хранятся, список только связывает их
+    std::vector<HookedValue> values(_count);
+    for (int i = 0; i < _count; i++) {
+        values[i].a = i;
+    }
+
+    {
+        CountingAllocator allocator;
+        DlPtrList<HookedValue, CountingAllocator> list(allocator, 50, 50);
+        for (int i = 0; i < _count; i++) {
+            list.addLast(&values[i]);
+        }
+
+        printBytes("DlPtrList", allocator.size());
+        measureTraverse("DlPtrList traverse", list, expected);
+    }
+
+    {
+        IntrusiveDlList<HookedValue> list;
+        for (int i = 0; i < _count; i++) {
+            list.addLast(&values[i]);
+        }
+
+        measureTraverse("IntrusiveDlList traverse", list, expected);
+
+        // объект исключает себя сам
+        values[0].unlink();
+        list.remove(&values[1]);
+        list.insertAfter(&values[2], &values[1]);
+        list.addFirst(&values[0]);
+        if (list.first() != &values[0] || list.removeLast() != &values[_count - 1] ||
+            list.count() != size_t(_count) - 1) {
+            RAISE(RuntimeException, "Invalid IntrusiveDlList state");
+        }
+    }
+
+    {
+        using Hook = MemberHook<HookedValue, SlHook, &HookedValue::slHook>;
+        IntrusiveSlList<HookedValue, Hook> list;
+        for (int i = 0; i < _count; i++) {
+            list.addLast(&values[i]);
+        }
+
+        measureTraverse("IntrusiveSlList traverse", list, expected);
+
+        list.remove(&values[1]);
+        list.insertAfter(&values[0], &values[1]);
+        if (list.removeFirst() != &values[0] || list.first() != &values[1] ||
+            values[0].slHook.isLinked()) {
+            RAISE(RuntimeException, "Invalid IntrusiveSlList state");
+        }
+    }
+
+    // связи не копируются: копия объекта из списка в нём не состоит,
+    // присваивание оставляет объект в его списке
+    {
+        HookedValue first;
+        HookedValue second;
+        IntrusiveDlList<HookedValue> list;
+        using Hook = MemberHook<HookedValue, SlHook, &HookedValue::slHook>;
+        IntrusiveSlList<HookedValue, Hook> slList;
+        list.addLast(&first);
+        slList.addLast(&first);
+
+        HookedValue copy(first);
+        HookedValue assigned;
+        assigned = first;
+        first = second;
+        first.a = 7;
+
+        if (copy.isLinked() || copy.slHook.isLinked() || assigned.isLinked() ||
+            assigned.slHook.isLinked() || !first.isLinked() || !first.slHook.isLinked()) {
+            RAISE(RuntimeException, "Hook links were copied");
+        }
+
+        if (list.count() != 1 || slList.count() != 1 || list.first()->a != 7 ||
+            slList.first()->a != 7) {
+            RAISE(RuntimeException, "Copy corrupted the intrusive list");
+        }
+    }
+}
+
+void TestLists::spliceTest()
+{
+    using List = DlObjList<Task, CountingAllocator, Internal::SharedNodePool>;
+    const int LEVELS = 4;
+
+    CountingAllocator allocator;
+    List::NodePoolType pool(allocator, 64, 0);
+    List low(pool);
+    List high(pool);
+
+    Task::created = 0;
+    std::vector<List::Item> items;
+    for (int i = 0; i < _count / 10; i++) {
+        items.push_back(low.addLast(i % LEVELS));
+    }
+
+    // задачи переходят между очередями приоритетов, объекты не пересоздаются
+    Time startTime = high_resolution_clock::now();
+    for (int pass = 0; pass < _passCount; pass++) {
+        for (auto& item : items) {
+            high.splice(item, low);
+        }
+        low.spliceAll(high);
+    }
+    Time endTime = high_resolution_clock::now();
+
+    cout << "DlObjList splice ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+
+    if (Task::created != _count / 10 || low.count() != size_t(_count / 10) || high.count() != 0) {
+        RAISE(RuntimeException, "Invalid splice result");
+    }
+
+    high.splice(items[10], items[19], low);
+    if (high.count() != 10 || low.count() != size_t(_count / 10 - 10)) {
+        RAISE(RuntimeException, "Invalid range splice result");
+    }
+
+    // диапазон из самого списка образовал бы цикл
+    try {
+        high.splice(items[10], items[19], high);
+        RAISE(RuntimeException, "Range splice into itself accepted");
+    } catch (ArgumentException&) {
+    }
+
+#ifdef DEBUG
+    // в Debug диапазон и элемент чужого списка отвергаются
+    try {
+        low.splice(items[30], items[31], high);
+        RAISE(RuntimeException, "Foreign range splice accepted");
+    } catch (ArgumentException&) {
+    }
+
+    try {
+        low.splice(items[40], high);
+        RAISE(RuntimeException, "Foreign item splice accepted");
+    } catch (ArgumentException&) {
+    }
+
+    if (high.count() != 10 || low.count() != size_t(_count / 10 - 10)) {
+        RAISE(RuntimeException, "Rejected splice changed the lists");
+    }
+#endif
+
+    // слияние двух упорядоченных списков
+    List left(pool);
+    List right(pool);
+    for (int i = 0; i < 100; i++) {
+        left.addLast(i * 2);
+        right.addLast(i * 3);
+    }
+
+    left.merge(right, [](Task* a, Task* b) { return a->priority < b->priority; });
+
+    int prev = -1;
+    for (auto& task : left) {
+        if (task.priority < prev) {
+            RAISE(RuntimeException, "Invalid merge order");
+        }
+        prev = task.priority;
+    }
+
+    if (left.count() != 200 || right.count() != 0) {
+        RAISE(RuntimeException, "Invalid merge result");
+    }
+}
+
+void TestLists::tinyTest()
+{
+    CountingAllocator allocator;
+    auto addList = [](auto& list) { list.addLast(1); };
+
+    measureTiny<DlObjList<Value, CountingAllocator>>("DlObjList", allocator, addList, allocator, 16, 1);
+    measureTiny<SlObjList<Value, CountingAllocator>>("SlObjList", allocator, addList, allocator, 16, 1);
+
+    // миллионы списков берут узлы из одного пула
+    using SharedDl = DlObjList<Value, CountingAllocator, Internal::SharedNodePool>;
+    using SharedSl = SlObjList<Value, CountingAllocator, Internal::SharedNodePool>;
+    SharedDl::NodePoolType dlPool(allocator, 1024, 0);
+    SharedSl::NodePoolType slPool(allocator, 1024, 0);
+    measureTiny<SharedDl>("Shared DlObjList", allocator, addList, dlPool);
+    measureTiny<SharedSl>("Shared SlObjList", allocator, addList, slPool);
+
+    measureTiny<ObjQueue<Value, CountingAllocator, 8>>(
+        "ObjQueue", allocator, [](auto& queue) { queue.enqueue(1); }, allocator, 1
+    );
+}
+
+void TestLists::sortTest()
+{
+    for (int size = 10000; size <= _count; size *= 10) {
+        measureSort<SlObjList<Value, CountingAllocator>>("SlObjList", size);
+        measureSort<DlObjList<Value, CountingAllocator>>("DlObjList", size);
+    }
+
+    // после сортировки item указывает на тот же элемент, добавление в
+    // конец идёт после нового последнего
+    CountingAllocator allocator;
+    SlObjList<Value, CountingAllocator> list(allocator, 16, 0);
+    list.sort([](Value* a, Value* b) { return a->a < b->a; });
+    auto item = list.addLast(3);
+    list.addLast(1);
+    list.sort([](Value* a, Value* b) { return a->a < b->a; });
+    list.addLast(5);
+    list.remove(item);
+
+    int expected[] = {1, 5};
+    int index = 0;
+    for (auto& value : list) {
+        if (value.a != expected[index++]) {
+            RAISE(RuntimeException, "Invalid sorted list state");
+        }
+    }
+}
+
+void TestLists::iteratorTest()
+{
+    using List = DlObjList<Value, CountingAllocator>;
+    static_assert(
+        std::is_same<std::iterator_traits<List::Iter>::iterator_category,
+                     std::bidirectional_iterator_tag>::value,
+        "DlObjList iterator must be bidirectional"
+    );
+    static_assert(
+        std::is_same<std::iterator_traits<SlObjList<Value, CountingAllocator>::Iter>::iterator_category,
+                     std::forward_iterator_tag>::value,
+        "SlObjList iterator must be forward"
+    );
+    static_assert(
+        std::is_same<List::ConstIter::reference, const Value&>::value,
+        "Const iterator must give a const reference"
+    );
+
+    CountingAllocator allocator;
+    List list(allocator, 16, 0);
+    for (int i = 0; i < 10; i++) {
+        list.addLast(i);
+    }
+
+    // алгоритмы STL получают ссылки на значения
+    auto found = std::find_if(list.begin(), list.end(), [](const Value& value) { return value.a == 7; });
+    auto odd = std::count_if(list.begin(), list.end(), [](const Value& value) { return value.a % 2; });
+    auto sum = std::accumulate(list.begin(), list.end(), 0, [](int sum, const Value& value) {
+        return sum + value.a;
+    });
+    if (found == list.end() || found->a != 7 || odd != 5 || sum != 45 ||
+        std::distance(list.begin(), list.end()) != 10 || std::prev(list.end())->a != 9) {
+        RAISE(RuntimeException, "Invalid STL algorithm result");
+    }
+
+    int expected = 9;
+    const List& constList = list;
+    for (auto it = constList.rbegin(); it != constList.rend(); ++it) {
+        if (it->a != expected--) {
+            RAISE(RuntimeException, "Invalid reverse traverse");
+        }
+    }
+
+    // алгоритмы, которым нужны прямой и двунаправленный итераторы
+    std::reverse(list.begin(), list.end());
+    auto middle = std::partition(list.begin(), list.end(), [](const Value& value) { return value.a % 2 == 0; });
+    if (list.begin()->a % 2 != 0 || middle->a % 2 != 1 || std::distance(list.begin(), middle) != 5) {
+        RAISE(RuntimeException, "Invalid mutating STL algorithm result");
+    }
+
+    // узлы в порядке обхода разбросаны по пулу после сортировки по
+    // случайному ключу
+    {
+        List scattered(allocator, 64, 0);
+        fillRandom(scattered, _count);
+        scattered.sort([](Value* a, Value* b) { return a->b % 7919 < b->b % 7919; });
+        int64_t expected = std::accumulate(scattered.cbegin(), scattered.cend(), int64_t(0),
+            [](int64_t sum, const Value& value) { return sum + value.a; }
+        ) * _passCount;
+
+        auto prefetched = scattered.prefetched();
+        measureTraverse("DlObjList scattered traverse", scattered, expected);
+        measureTraverse("DlObjList scattered prefetch traverse", prefetched, expected);
+    }
+
+    {
+        using SlList = SlObjList<Value, CountingAllocator>;
+        SlList scattered(allocator, 64, 0);
+        fillRandom(scattered, _count);
+        scattered.sort([](Value* a, Value* b) { return a->b % 7919 < b->b % 7919; });
+        int64_t expected = 0;
+        for (SlList::ConstIter it = scattered.begin(); it != scattered.end(); it++) {
+            expected += it->a;
+        }
+        expected *= _passCount;
+
+        auto prefetched = scattered.prefetched();
+        measureTraverse("SlObjList scattered traverse", scattered, expected);
+        measureTraverse("SlObjList scattered prefetch traverse", prefetched, expected);
+    }
+}
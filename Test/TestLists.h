@@ -0,0 +1,21 @@
+﻿#ifndef TESTLISTS_H
+#define TESTLISTS_H
+
+
+class TestLists
+{
+public:
+    TestLists();
+
+    void run();
+private:
+    void compactTest();
+    void shrinkTest();
+    void intrusiveTest();
+    void spliceTest();
+    void tinyTest();
+    void sortTest();
+    void iteratorTest();
+};
+
+#endif // TESTLISTS_H
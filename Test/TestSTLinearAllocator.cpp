@@ -4,6 +4,7 @@
 #include <chrono>
 #include <thread>
 #include "../LinearAllocator.h"
+#include "../Exception.h"
 
 //#define CHECK_RESULT
 
@@ -81,6 +82,8 @@ void TestSTLinearAllocator::run()
 
     speedTest();
     speedTestThreads();
+    childTest();
+    childSpeedTest();
 }
 
 void TestSTLinearAllocator::speedTest()
@@ -192,3 +195,71 @@ void TestSTLinearAllocator::speedTestThreads()
 #endif
     }
 }
+
+void TestSTLinearAllocator::childTest()
+{
+    STLinearAllocator root(true);
+
+    for (int i = 0; i < 100; i++) {
+        STLinearAllocator connection(root);
+        auto header = reinterpret_cast<uint64_t*>(connection.alloc(64));
+        *header = i;
+
+        for (int j = 0; j < 10; j++) {
+            STLinearAllocator request(connection, 256);
+
+            // выходим за первый блок, регионы одалживаются у root
+            for (int k = 0; k < 100; k++) {
+                auto value = reinterpret_cast<uint64_t*>(request.alloc(4096, 64));
+                *value = k;
+            }
+
+            request.reset();
+            request.alloc(1 << 20);
+        }
+
+        if (*header != uint64_t(i)) {
+            RAISE(RuntimeException, "Child allocator damaged parent memory");
+        }
+    }
+
+    root.reset();
+    root.alloc(1024);
+}
+
+void TestSTLinearAllocator::childSpeedTest()
+{
+    const int scopeCount = 100000;
+    const int allocCount = 8;
+
+    {
+        Time startTime = high_resolution_clock::now();
+
+        for (int i = 0; i < scopeCount; i++) {
+            STLinearAllocator scope(true);
+            for (int j = 0; j < allocCount; j++) {
+                uint64_t* value = reinterpret_cast<uint64_t*>(scope.alloc(_size));
+                *value = 10;
+            }
+        }
+
+        Time endTime = high_resolution_clock::now();
+        cout << "root scopes ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        Time startTime = high_resolution_clock::now();
+
+        STLinearAllocator root(true);
+        for (int i = 0; i < scopeCount; i++) {
+            STLinearAllocator scope(root, 256);
+            for (int j = 0; j < allocCount; j++) {
+                uint64_t* value = reinterpret_cast<uint64_t*>(scope.alloc(_size));
+                *value = 10;
+            }
+        }
+
+        Time endTime = high_resolution_clock::now();
+        cout << "child scopes ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+}
@@ -11,6 +11,8 @@ public:
 private:
     void speedTest();
     void speedTestThreads();
+    void childTest();
+    void childSpeedTest();
 };
 
 #endif // TESTSTLINEARALLOCATOR_H
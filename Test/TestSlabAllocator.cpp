@@ -0,0 +1,179 @@
+﻿#include "TestSlabAllocator.h"
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../SlabAllocator.h"
+#include "../Exception.h"
+#include "../Align.h"
+
+using namespace std;
+using namespace std::chrono;
+using Time = std::chrono::high_resolution_clock::time_point;
+
+class MallocAllocator
+{
+public:
+    void* alloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void free(void* ptr)
+    {
+        ::free(ptr);
+    }
+};
+
+// кол-во одновременно живых блоков
+static const int _slotCount = 4096;
+// кол-во пар alloc/free на поток
+static int _count = 1000000;
+static const int _threadCount = 4;
+
+static uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Держит _slotCount живых блоков размером 16-512 байт и заменяет случайный
+// блок на каждой итерации.
+template<class Alloc>
+void churn(Alloc& alloc, uint32_t seed)
+{
+    void* slots[_slotCount];
+    uint32_t state = seed;
+
+    for (int i = 0; i < _slotCount; i++) {
+        slots[i] = alloc.alloc(16 + nextRandom(state) % 497);
+    }
+
+    for (int i = 0; i < _count; i++) {
+        int slot = nextRandom(state) % _slotCount;
+        alloc.free(slots[slot]);
+
+        auto value = reinterpret_cast<uint64_t*>(
+            alloc.alloc(16 + nextRandom(state) % 497)
+        );
+
+        *value = i;
+        slots[slot] = value;
+    }
+
+    for (int i = 0; i < _slotCount; i++) {
+        alloc.free(slots[i]);
+    }
+}
+
+void threadRunSlab(uint32_t seed)
+{
+    STSlabAllocator allocator;
+    churn(allocator, seed);
+}
+
+void threadRunSlabMalloc(uint32_t seed)
+{
+    MallocAllocator allocator;
+    churn(allocator, seed);
+}
+
+template<class Func>
+void runThreads(const char* name, Func func)
+{
+    Time startTime = high_resolution_clock::now();
+
+    thread threads[_threadCount];
+    for (int i = 0; i < _threadCount; i++) {
+        threads[i] = thread(func, i + 1);
+    }
+
+    for (int i = 0; i < _threadCount; i++) {
+        threads[i].join();
+    }
+
+    Time endTime = high_resolution_clock::now();
+    cout << name << " ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+}
+
+TestSlabAllocator::TestSlabAllocator()
+{
+
+}
+
+void TestSlabAllocator::run()
+{
+    checkAlloc();
+    speedTest();
+    speedTestThreads();
+}
+
+void TestSlabAllocator::checkAlloc()
+{
+    STSlabAllocator allocator;
+
+    const int COUNT = 20000;
+    void* blocks[COUNT];
+    for (int i = 0; i < COUNT; i++) {
+        size_t size = 1 + i % 700;
+        size_t align = size_t(1) << (i % 8);
+
+        blocks[i] = allocator.alloc(size, align);
+        if (!checkAlign(blocks[i], align) || STSlabAllocator::getSize(blocks[i]) < size) {
+            RAISE(RuntimeException, "Invalid slab block");
+        }
+    }
+
+    // освобождаем через один, чтобы слэбы стали частично заполнены
+    for (int i = 0; i < COUNT; i += 2) {
+        allocator.free(blocks[i]);
+    }
+
+    for (int i = 0; i < COUNT; i += 2) {
+        blocks[i] = allocator.alloc(1 + i % 700);
+    }
+
+    for (int i = 0; i < COUNT; i++) {
+        allocator.free(blocks[i]);
+    }
+
+    void* large = allocator.alloc(1 << 20, 4096);
+    if (!checkAlign(large, 4096)) {
+        RAISE(RuntimeException, "Invalid large block");
+    }
+
+    allocator.free(large);
+}
+
+void TestSlabAllocator::speedTest()
+{
+    {
+        Time startTime = high_resolution_clock::now();
+
+        STSlabAllocator allocator;
+        churn(allocator, 1);
+
+        Time endTime = high_resolution_clock::now();
+        cout << "slab ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+
+    {
+        Time startTime = high_resolution_clock::now();
+
+        MallocAllocator allocator;
+        churn(allocator, 1);
+
+        Time endTime = high_resolution_clock::now();
+        cout << "malloc ellapsed: " << duration_cast<milliseconds>(endTime - startTime).count() << endl;
+    }
+}
+
+void TestSlabAllocator::speedTestThreads()
+{
+    runThreads("slab threads", &threadRunSlab);
+    runThreads("malloc threads", &threadRunSlabMalloc);
+}
@@ -0,0 +1,17 @@
+﻿#ifndef TESTSLABALLOCATOR_H
+#define TESTSLABALLOCATOR_H
+
+
+class TestSlabAllocator
+{
+public:
+    TestSlabAllocator();
+
+    void run();
+private:
+    void checkAlloc();
+    void speedTest();
+    void speedTestThreads();
+};
+
+#endif // TESTSLABALLOCATOR_H
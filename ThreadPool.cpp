@@ -0,0 +1,107 @@
+﻿#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+    _invoke = nullptr;
+    _context = nullptr;
+    _count = 0;
+    _next.store(0);
+    _busy = 0;
+    _generation = 0;
+    _stop = false;
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (size_t i = 1; i < threadCount; i++) {
+        _workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+    }
+
+    _wake.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::execute(size_t count, Invoke invoke, void* context)
+{
+    std::lock_guard<std::mutex> runGuard(_runLock);
+
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _invoke = invoke;
+        _context = context;
+        _count = count;
+        _next.store(0);
+        _error = nullptr;
+        _busy = _workers.size();
+        _generation++;
+    }
+
+    _wake.notify_all();
+    work();
+
+    std::unique_lock<std::mutex> guard(_lock);
+    _done.wait(guard, [this]() { return _busy == 0; });
+
+    if (_error) {
+        auto error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(_lock);
+            _wake.wait(guard, [&]() { return _stop || _generation != generation; });
+            if (_stop) {
+                return;
+            }
+
+            generation = _generation;
+        }
+
+        work();
+
+        std::lock_guard<std::mutex> guard(_lock);
+        if (--_busy == 0) {
+            _done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::work()
+{
+    while (true) {
+        auto index = _next.fetch_add(1);
+        if (index >= _count) {
+            return;
+        }
+
+        try {
+            _invoke(_context, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(_lock);
+            if (!_error) {
+                _error = std::current_exception();
+            }
+
+            _next.store(_count);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+﻿#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <exception>
+#include <condition_variable>
+
+//##############################################################################
+//
+// ThreadPool
+//  Постоянные потоки для параллельной обработки. run() раздаёт индексы
+//  заданий потокам пула и вызывающему потоку, пока задания не кончатся,
+//  и ждёт завершения всех. Одновременно выполняется одно run().
+//
+//##############################################################################
+
+class ThreadPool
+{
+public:
+    // threadCount - всего потоков вместе с вызывающим, 0 - по числу ядер.
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    size_t threadCount() const
+    {
+        return _workers.size() + 1;
+    }
+
+    // Вызывает func(index) для каждого index из [0, count). Первое
+    // исключение из func передаётся вызывающему, оставшиеся задания
+    // при этом не запускаются.
+    template<class Func>
+    void run(size_t count, Func& func)
+    {
+        execute(count, &invoke<Func>, &func);
+    }
+private:
+    using Invoke = void (*)(void* context, size_t index);
+
+    std::vector<std::thread> _workers;
+    std::mutex _runLock;
+    std::mutex _lock;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+
+    // текущее задание, меняется под _lock
+    Invoke _invoke;
+    void* _context;
+    size_t _count;
+    std::atomic<size_t> _next;
+    // потоки пула, ещё не закончившие текущее задание
+    size_t _busy;
+    uint64_t _generation;
+    std::exception_ptr _error;
+    bool _stop;
+
+    ThreadPool(const ThreadPool&) = delete;
+
+    template<class Func>
+    static void invoke(void* context, size_t index)
+    {
+        (*static_cast<Func*>(context))(index);
+    }
+
+    void execute(size_t count, Invoke invoke, void* context);
+    void workerLoop();
+    void work();
+};
+
+#endif // THREADPOOL_H
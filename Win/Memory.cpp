@@ -31,10 +31,29 @@ size_t Memory::getPageSize()
 }
 
 void* Memory::allocRegion(size_t& size)
+{
+    return allocRegion(size, nullptr);
+}
+
+void* Memory::allocRegion(size_t& size, void* hint)
 {
     size = alignValue(size, _pageSize);
 
-    void* region = VirtualAlloc(
+    void* region = nullptr;
+    if (hint != nullptr) {
+        region = VirtualAlloc(
+            hint,
+            size,
+            MEM_RESERVE | MEM_COMMIT,
+            PAGE_READWRITE
+        );
+
+        if (region != nullptr) {
+            return region;
+        }
+    }
+
+    region = VirtualAlloc(
         nullptr,
         size,
         MEM_RESERVE | MEM_COMMIT,
@@ -50,6 +69,51 @@ void* Memory::allocRegion(size_t& size)
     return region;
 }
 
+void* Memory::allocAlignedRegion(size_t& size, size_t align)
+{
+    // VirtualAlloc всегда выравнивает на гранулярность выделения (64kb)
+    if (align <= _pageSize) {
+        return allocRegion(size);
+    }
+
+    size = alignValue(size, _pageSize);
+
+    // Резервируем с запасом, освобождаем и занимаем выровненный адрес.
+    // Между освобождением и повторным резервом адрес может занять другой
+    // поток, поэтому пробуем несколько раз.
+    const int ATTEMPT_COUNT = 8;
+    for (int i = 0; i < ATTEMPT_COUNT; i++) {
+        void* probe = VirtualAlloc(
+            nullptr,
+            size + align,
+            MEM_RESERVE,
+            PAGE_NOACCESS
+        );
+
+        if (probe == nullptr) {
+            break;
+        }
+
+        void* aligned = alignValue(probe, align);
+        VirtualFree(probe, 0, MEM_RELEASE);
+
+        void* region = VirtualAlloc(
+            aligned,
+            size,
+            MEM_RESERVE | MEM_COMMIT,
+            PAGE_READWRITE
+        );
+
+        if (region != nullptr) {
+            return region;
+        }
+    }
+
+    RAISE(BadAllocException,
+        "VirtualAlloc failed with reason: " + getLastErrorMessage()
+    );
+}
+
 void Memory::freeRegion(void* region, size_t size)
 {
     size = 0;
@@ -59,3 +123,47 @@ void Memory::freeRegion(void* region, size_t size)
         );
     }
 }
+
+void Memory::mapFile(const char* path, void* address, size_t size)
+{
+    // Отображение файла поверх уже выделенной памяти в Windows невозможно,
+    // поэтому содержимое читается в регион.
+    HANDLE file = CreateFileA(
+        path,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr
+    );
+
+    if (file == INVALID_HANDLE_VALUE) {
+        RAISE(RuntimeException,
+            "CreateFile failed with reason: " + getLastErrorMessage()
+        );
+    }
+
+    uint8_t* dst = static_cast<uint8_t*>(address);
+    while (size > 0) {
+        DWORD portion = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+        DWORD readed = 0;
+
+        if (!ReadFile(file, dst, portion, &readed, nullptr)) {
+            CloseHandle(file);
+            RAISE(RuntimeException,
+                "ReadFile failed with reason: " + getLastErrorMessage()
+            );
+        }
+
+        if (readed == 0) {
+            CloseHandle(file);
+            RAISE(RuntimeException, "File is shorter than mapped size");
+        }
+
+        dst += readed;
+        size -= readed;
+    }
+
+    CloseHandle(file);
+}
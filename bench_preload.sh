@@ -0,0 +1,13 @@
+#!/bin/bash
+
+# Сравнивает MallocBench на glibc malloc и с libGreedyMalloc.so.
+# Параметр - каталог сборки, по умолчанию Linux64_Release.
+
+BUILD_PATH=${1:-${PWD}/build/Linux64_Release}
+THREAD_COUNT=${2:-4}
+
+echo "glibc"
+${BUILD_PATH}/MallocBench ${THREAD_COUNT}
+
+echo "GreedyMalloc"
+LD_PRELOAD=${BUILD_PATH}/libGreedyMalloc.so ${BUILD_PATH}/MallocBench ${THREAD_COUNT}
@@ -16,6 +16,11 @@
 #include "Collections/Pool.h"
 #include "TestStorage.h"
 #include "Test/TestSTLinearAllocator.h"
+#include "Test/TestSlabAllocator.h"
+#include "Test/TestLists.h"
+#include "Test/TestArena.h"
+#include "Test/TestConcurrentPool.h"
+#include "Test/TestChunked.h"
 #include "Test/TestFile.h"
 
 using namespace std;
@@ -145,6 +150,76 @@ void testSTLinearAllocator()
     }
 }
 
+void testSlabAllocator()
+{
+    cout << "start testSlabAllocator" << endl;
+
+    try
+    {
+        TestSlabAllocator test;
+        test.run();
+    }
+    catch (const Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void testLists()
+{
+    cout << "start testLists" << endl;
+
+    try
+    {
+        TestLists test;
+        test.run();
+    }
+    catch (const Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void testArena()
+{
+    cout << "start testArena" << endl;
+
+    try
+    {
+        TestArena test;
+        test.run();
+    }
+    catch (const Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void testConcurrentPool()
+{
+    cout << "start testConcurrentPool" << endl;
+
+    try
+    {
+        TestConcurrentPool test;
+        test.run();
+    }
+    catch (const Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+void testChunked()
+{
+    cout << "start testChunked" << endl;
+
+    try
+    {
+        TestChunked test;
+        test.run();
+    }
+    catch (const Exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
 void signalHandler(int sig)
 {
     throw runtime_error("signalHandler");
@@ -207,11 +282,15 @@ class SimpleAllocator
 {
 public:
     void* alloc(size_t size) {
-        return malloc(size);
+        return alloc(size, DEFAULT_ALIGN);
     }
 
     void* alloc(size_t size, size_t align) {
-        return malloc(size);
+        return getAlignedMemory(alignValue(size, align), align);
+    }
+
+    void free(void* ptr) {
+        freeAlignedMemory(ptr);
     }
 };
 
@@ -233,7 +312,12 @@ int main(int argc, char *argv[])
     testEnv();
     testAssert();
     testStorage();
-    //testSTLinearAllocator();
+    testSTLinearAllocator();
+    testSlabAllocator();
+    testLists();
+    testArena();
+    testConcurrentPool();
+    testChunked();
 
     try
     {
@@ -250,18 +334,18 @@ int main(int argc, char *argv[])
             int h = i1->a;
             l.remove(i1);
 
-            for (auto value : l) {
-                cout << value->a << endl;
+            for (auto& value : l) {
+                cout << value.a << endl;
             }
 
             SlObjList l2 = move(l);
 
-            for (auto value : l) {
-                cout << value->a << endl;
+            for (auto& value : l) {
+                cout << value.a << endl;
             }
 
-            for (auto value : l2) {
-                cout << value->a << endl;
+            for (auto& value : l2) {
+                cout << value.a << endl;
             }
         }
 
@@ -312,18 +396,18 @@ int main(int argc, char *argv[])
             int h = i1->a;
             l.remove(i1);
 
-            for (auto value : l) {
-                cout << value->a << endl;
+            for (auto& value : l) {
+                cout << value.a << endl;
             }
 
             DlObjList l2 = move(l);
 
-            for (auto value : l) {
-                cout << value->a << endl;
+            for (auto& value : l) {
+                cout << value.a << endl;
             }
 
-            for (auto value : l2) {
-                cout << value->a << endl;
+            for (auto& value : l2) {
+                cout << value.a << endl;
             }
         }
 
@@ -460,15 +544,15 @@ int main(int argc, char *argv[])
             }
 
             auto arr = l.toArray();
-            for (auto value : arr) {
-                cout << value->a << endl;
+            for (auto& value : arr) {
+                cout << value.a << endl;
             }
 
             l.clear();
 
             auto arr2 = l.toArray();
-            for (auto value : arr2) {
-                cout << value->a << endl;
+            for (auto& value : arr2) {
+                cout << value.a << endl;
             }
 
             auto e2 = l.getEnumerator();